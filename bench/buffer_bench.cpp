@@ -0,0 +1,83 @@
+// Author: Cukoo
+// Date: 2026-10-18
+
+// Buffer 的基准测试：追加、从 fd 读取（readv）、部分取走、合并跨块的数据
+
+#include <benchmark/benchmark.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string>
+
+#include "buffer/buffer.h"
+
+namespace {
+
+// 追加 state.range(0) 字节后全部取走，块在 ChunkPool 的线程缓存中循环使用
+void BM_BufferAppend(benchmark::State& state) {
+    const std::string data(state.range(0), 'x');
+    Buffer buff;
+    for (auto _ : state) {
+        buff.Append(data);
+        benchmark::DoNotOptimize(buff.ReadBegin());
+        buff.RetrieveAll();
+    }
+    state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_BufferAppend)->Arg(64)->Arg(1024)->Arg(16 * 1024);
+
+// 从管道中读取 state.range(0) 字节，直接读入链尾的剩余空间和若干新块
+void BM_BufferReadFd(benchmark::State& state) {
+    const std::string data(state.range(0), 'x');
+    int fds[2];
+    if (pipe2(fds, O_NONBLOCK) < 0) {
+        state.SkipWithError("pipe2 failed");
+        return;
+    }
+    fcntl(fds[1], F_SETPIPE_SZ, 1 << 20);
+    Buffer buff;
+    int save_errno = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        benchmark::DoNotOptimize(write(fds[1], data.data(), data.size()));
+        state.ResumeTiming();
+        benchmark::DoNotOptimize(buff.ReadFd(fds[0], &save_errno));
+        buff.RetrieveAll();
+    }
+    state.SetBytesProcessed(state.iterations() * data.size());
+    close(fds[0]);
+    close(fds[1]);
+}
+BENCHMARK(BM_BufferReadFd)->Arg(512)->Arg(4096)->Arg(64 * 1024);
+
+// 每次取走一半多：数据跨越多个块，读完的块随即归还
+void BM_BufferPartialRetrieve(benchmark::State& state) {
+    const std::string data(state.range(0), 'x');
+    Buffer buff;
+    for (auto _ : state) {
+        buff.Append(data);
+        buff.Retrieve(buff.ReadableBytes() / 2 + 1);
+        if (buff.ReadableBytes() > 2 * data.size()) {
+            buff.RetrieveAll();
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_BufferPartialRetrieve)->Arg(256)->Arg(4096);
+
+// 请求报文跨越块的边界：先追加到第一个块快满，再追加 state.range(0) 字节，然后合并
+void BM_BufferLinearize(benchmark::State& state) {
+    const std::string head(ChunkPool::kCapacity_ - 16, 'x');
+    const std::string data(state.range(0), 'y');
+    Buffer buff;
+    for (auto _ : state) {
+        buff.Append(head);
+        buff.Retrieve(head.size() - 16);
+        buff.Append(data);
+        benchmark::DoNotOptimize(buff.Linearize());
+        buff.RetrieveAll();
+    }
+    state.SetBytesProcessed(state.iterations() * (data.size() + 16));
+}
+BENCHMARK(BM_BufferLinearize)->Arg(256)->Arg(16 * 1024);
+
+}  // namespace
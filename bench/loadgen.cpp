@@ -0,0 +1,807 @@
+// Author: Cukoo
+// Date: 2026-10-18
+
+// HTTP 压测工具：多线程，每个线程用一个 epoll 驱动自己的连接
+// - 支持长连接、流水线（每个连接同时未完成的请求数）、请求混合（静态文件 GET、登录 POST）
+// - 闭环模式：每个连接收到响应后立即发送下一个请求
+// - 开环模式（--rate）：按固定速率安排请求，延迟从请求被安排的时刻算起，
+//   服务器变慢时排队的时间也计入延迟，避免协调遗漏（coordinated omission）
+// - 延迟直方图（对数分桶，相对误差小于 1%），输出 p50/p90/p99/p999，可以输出 JSON
+// 用法：./loadgen -p 1027 -t 4 -c 64 -d 10 [-D 4] [-r 20000] [-m static=9,login=1] [--json out.json]
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <strings.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+
+int64_t Now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// 请求的种类
+enum class RequestType {
+    STATIC,  // GET 静态文件
+    LOGIN,   // POST 登录表单
+    COUNT
+};
+
+const char* const kRequestTypeNames[] = {"static", "login"};
+
+struct Options {
+    std::string host = "127.0.0.1";
+    int port = 1027;
+    int threads = 1;
+    int connections = 10;
+    double duration = 10;  // 单位：s
+    int depth = 1;         // 每个连接同时未完成的请求数
+    double rate = 0;       // 单位：请求/s（所有线程合计），0 表示闭环模式
+    bool keep_alive = true;
+    std::string path = "/index.html";
+    std::string user = "alice";
+    std::string password = "pw";
+    int weights[static_cast<int>(RequestType::COUNT)] = {1, 0};
+    std::string json;  // JSON 结果的输出路径，"-" 表示标准输出
+};
+
+// 延迟直方图（单位：us）：小于 2^kSubBits 的值精确记录，更大的值每个 2 的幂区间分为 2^(kSubBits-1) 个桶
+class Histogram {
+   public:
+    Histogram() : buckets_(Index(UINT64_MAX >> 1) + 1, 0) {}
+
+    void Record(uint64_t value) {
+        value = std::min<uint64_t>(value, UINT64_MAX >> 1);
+        ++buckets_[Index(value)];
+        ++count_;
+        sum_ += value;
+        max_ = std::max(max_, value);
+    }
+
+    void Merge(const Histogram& other) {
+        for (size_t i = 0; i < buckets_.size(); ++i) {
+            buckets_[i] += other.buckets_[i];
+        }
+        count_ += other.count_;
+        sum_ += other.sum_;
+        max_ = std::max(max_, other.max_);
+    }
+
+    // q 分位数（0 ~ 1），返回所在桶的上界
+    uint64_t Percentile(double q) const {
+        if (count_ == 0) {
+            return 0;
+        }
+        uint64_t rank = static_cast<uint64_t>(std::ceil(q * count_));
+        rank = std::max<uint64_t>(rank, 1);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < buckets_.size(); ++i) {
+            seen += buckets_[i];
+            if (seen >= rank) {
+                return std::min(UpperBound(i), max_);
+            }
+        }
+        return max_;
+    }
+
+    uint64_t count() const { return count_; }
+    uint64_t max() const { return max_; }
+    double mean() const { return count_ ? static_cast<double>(sum_) / count_ : 0; }
+
+   private:
+    static constexpr int kSubBits = 8;
+    static constexpr uint64_t kHalf = 1ull << (kSubBits - 1);
+
+    static size_t Index(uint64_t value) {
+        if (value < (1ull << kSubBits)) {
+            return value;
+        }
+        int shift = 63 - __builtin_clzll(value) - (kSubBits - 1);
+        return shift * kHalf + (value >> shift);
+    }
+
+    static uint64_t UpperBound(size_t idx) {
+        if (idx < (1ull << kSubBits)) {
+            return idx;
+        }
+        int shift = idx / kHalf - 1;
+        uint64_t mantissa = idx - shift * kHalf;
+        return ((mantissa + 1) << shift) - 1;
+    }
+
+    std::vector<uint64_t> buckets_;
+    uint64_t count_ = 0;
+    uint64_t sum_ = 0;
+    uint64_t max_ = 0;
+};
+
+struct Stats {
+    void Merge(const Stats& other) {
+        latency.Merge(other.latency);
+        sent += other.sent;
+        completed += other.completed;
+        errors += other.errors;
+        connects += other.connects;
+        connect_errors += other.connect_errors;
+        bytes += other.bytes;
+        max_backlog = std::max(max_backlog, other.max_backlog);
+        for (int i = 0; i < 6; ++i) {
+            status[i] += other.status[i];
+        }
+    }
+
+    Histogram latency;
+    uint64_t sent = 0;
+    uint64_t completed = 0;
+    uint64_t errors = 0;  // 连接意外断开时未完成的请求
+    uint64_t connects = 0;
+    uint64_t connect_errors = 0;
+    uint64_t bytes = 0;        // 读到的字节数
+    uint64_t max_backlog = 0;  // 开环模式下等待空闲连接的请求数的最大值
+    uint64_t status[6] = {};   // 按状态码的首位数字计数，0 为无法解析的状态行
+};
+
+// 一个压测线程：自己的 epoll、连接和统计
+class Worker {
+   public:
+    Worker(const Options& opts, const sockaddr_in& addr, int conn_num, double rate, int seed)
+        : opts_(opts),
+          addr_(addr),
+          conns_(conn_num),
+          interval_(rate > 0 ? 1e9 / rate : 0),
+          rng_(seed) {
+        for (int i = 0; i < static_cast<int>(RequestType::COUNT); ++i) {
+            total_weight_ += opts_.weights[i];
+        }
+        requests_[static_cast<int>(RequestType::STATIC)] =
+            "GET " + opts_.path + " HTTP/1.1\r\nHost: " + opts_.host +
+            "\r\nConnection: " + (opts_.keep_alive ? "keep-alive" : "close") +
+            "\r\n\r\n";
+        std::string body = "username=" + opts_.user + "&password=" + opts_.password;
+        requests_[static_cast<int>(RequestType::LOGIN)] =
+            "POST /login HTTP/1.1\r\nHost: " + opts_.host +
+            "\r\nConnection: " + (opts_.keep_alive ? "keep-alive" : "close") +
+            "\r\nContent-Type: application/x-www-form-urlencoded\r\nContent-Length: " +
+            std::to_string(body.size()) + "\r\n\r\n" + body;
+    }
+
+    ~Worker() {
+        for (Conn& conn : conns_) {
+            if (conn.fd >= 0) {
+                close(conn.fd);
+            }
+        }
+        if (timerfd_ >= 0) {
+            close(timerfd_);
+        }
+        if (epfd_ >= 0) {
+            close(epfd_);
+        }
+    }
+
+    void Run(int64_t start, int64_t end) {
+        epfd_ = epoll_create1(EPOLL_CLOEXEC);
+        next_send_ = start;
+        if (interval_ > 0) {
+            // epoll_wait 的超时只精确到毫秒，用 timerfd 在安排的时刻（绝对时间）唤醒
+            timerfd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+            epoll_event ev = {};
+            ev.events = EPOLLIN;
+            ev.data.u32 = kTimerIdx;
+            epoll_ctl(epfd_, EPOLL_CTL_ADD, timerfd_, &ev);
+        }
+        for (size_t i = 0; i < conns_.size(); ++i) {
+            Connect(i);
+        }
+        std::vector<epoll_event> events(conns_.size() + 1);
+        for (int64_t now = Now(); now < end; now = Now()) {
+            if (interval_ > 0) {
+                Schedule(now);
+                Dispatch();
+                ArmTimer();
+            }
+            for (size_t i = 0; i < conns_.size(); ++i) {
+                if (conns_[i].fd < 0 && conns_[i].retry_at <= now) {
+                    Connect(i);
+                }
+            }
+            int n = epoll_wait(epfd_, events.data(), events.size(), 10);
+            for (int i = 0; i < n; ++i) {
+                size_t idx = events[i].data.u32;
+                if (idx == kTimerIdx) {
+                    uint64_t expirations;
+                    (void)!read(timerfd_, &expirations, sizeof(expirations));
+                    continue;
+                }
+                if (conns_[idx].fd < 0) {
+                    continue;
+                }
+                if (conns_[idx].connecting) {
+                    OnConnected(idx);
+                    continue;
+                }
+                if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                    OnReadable(idx);
+                }
+                if (conns_[idx].fd >= 0 && !conns_[idx].connecting &&
+                    (events[i].events & EPOLLOUT)) {
+                    Flush(idx);
+                }
+            }
+        }
+    }
+
+    const Stats& stats() const { return stats_; }
+
+   private:
+    struct Conn {
+        int fd = -1;
+        bool connecting = false;
+        bool want_write = false;
+        int64_t retry_at = 0;
+        std::string out;
+        size_t out_off = 0;
+        std::deque<int64_t> inflight;  // 已发送请求的开始时间（开环模式下为安排的时刻）
+        std::string in;
+        size_t in_off = 0;
+        int64_t body_left = -1;  // 当前响应剩余的响应体长度，-1 表示正在读响应头
+        bool until_close = false;  // 响应体没有长度，直到连接关闭
+        bool server_close = false;  // 当前响应之后服务器会关闭连接
+        int status = 0;
+    };
+
+    // 开环模式：把到期的请求按安排的时刻排队
+    void Schedule(int64_t now) {
+        while (next_send_ <= now) {
+            pending_.push_back(next_send_);
+            next_send_ += static_cast<int64_t>(interval_);
+        }
+        stats_.max_backlog = std::max<uint64_t>(stats_.max_backlog, pending_.size());
+    }
+
+    // 开环模式：在下一个请求安排的时刻唤醒
+    void ArmTimer() {
+        if (next_send_ == armed_at_) {
+            return;
+        }
+        armed_at_ = next_send_;
+        itimerspec spec = {};
+        spec.it_value.tv_sec = armed_at_ / 1000000000;
+        spec.it_value.tv_nsec = armed_at_ % 1000000000;
+        timerfd_settime(timerfd_, TFD_TIMER_ABSTIME, &spec, nullptr);
+    }
+
+    // 开环模式：把排队的请求分给未完成请求数小于流水线深度的连接（轮流）
+    void Dispatch() {
+        for (size_t tried = 0; !pending_.empty() && tried < conns_.size(); ++tried) {
+            size_t idx = rr_;
+            rr_ = (rr_ + 1) % conns_.size();
+            Conn& conn = conns_[idx];
+            if (conn.fd < 0 || conn.connecting) {
+                continue;
+            }
+            bool sent = false;
+            while (!pending_.empty() && static_cast<int>(conn.inflight.size()) < Depth()) {
+                Send(conn, pending_.front());
+                pending_.pop_front();
+                sent = true;
+            }
+            if (sent) {
+                tried = 0;
+                Flush(idx);
+            }
+        }
+    }
+
+    // 闭环模式：把连接上未完成的请求补满到流水线深度
+    void Fill(size_t idx) {
+        Conn& conn = conns_[idx];
+        if (interval_ > 0 || conn.fd < 0 || conn.connecting) {
+            return;
+        }
+        while (static_cast<int>(conn.inflight.size()) < Depth()) {
+            Send(conn, Now());
+        }
+        Flush(idx);
+    }
+
+    // 短连接时每个连接只有一个请求
+    int Depth() const { return opts_.keep_alive ? opts_.depth : 1; }
+
+    void Send(Conn& conn, int64_t start) {
+        conn.out += requests_[static_cast<int>(PickType())];
+        conn.inflight.push_back(start);
+        ++stats_.sent;
+    }
+
+    RequestType PickType() {
+        int r = std::uniform_int_distribution<int>(0, total_weight_ - 1)(rng_);
+        for (int i = 0; i < static_cast<int>(RequestType::COUNT); ++i) {
+            r -= opts_.weights[i];
+            if (r < 0) {
+                return static_cast<RequestType>(i);
+            }
+        }
+        return RequestType::STATIC;
+    }
+
+    void Connect(size_t idx) {
+        Conn& conn = conns_[idx];
+        conn = Conn();
+        conn.fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (conn.fd < 0) {
+            ConnectFailed(idx);
+            return;
+        }
+        int one = 1;
+        setsockopt(conn.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        int ret = connect(conn.fd, reinterpret_cast<const sockaddr*>(&addr_), sizeof(addr_));
+        if (ret < 0 && errno != EINPROGRESS) {
+            ConnectFailed(idx);
+            return;
+        }
+        conn.connecting = true;
+        epoll_event ev = {};
+        ev.events = EPOLLIN | EPOLLOUT;
+        ev.data.u32 = idx;
+        epoll_ctl(epfd_, EPOLL_CTL_ADD, conn.fd, &ev);
+    }
+
+    void OnConnected(size_t idx) {
+        Conn& conn = conns_[idx];
+        int err = 0;
+        socklen_t len = sizeof(err);
+        getsockopt(conn.fd, SOL_SOCKET, SO_ERROR, &err, &len);
+        if (err != 0) {
+            ConnectFailed(idx);
+            return;
+        }
+        ++stats_.connects;
+        conn.connecting = false;
+        conn.want_write = true;
+        SetWrite(idx, false);
+        Fill(idx);
+    }
+
+    // 连接失败时 100ms 后重试，避免空转
+    void ConnectFailed(size_t idx) {
+        ++stats_.connect_errors;
+        Close(idx);
+        conns_[idx].retry_at = Now() + 100000000;
+    }
+
+    void SetWrite(size_t idx, bool on) {
+        Conn& conn = conns_[idx];
+        if (conn.want_write == on) {
+            return;
+        }
+        conn.want_write = on;
+        epoll_event ev = {};
+        ev.events = EPOLLIN | (on ? EPOLLOUT : 0);
+        ev.data.u32 = idx;
+        epoll_ctl(epfd_, EPOLL_CTL_MOD, conn.fd, &ev);
+    }
+
+    void Flush(size_t idx) {
+        Conn& conn = conns_[idx];
+        while (conn.out_off < conn.out.size()) {
+            ssize_t n = write(conn.fd, conn.out.data() + conn.out_off,
+                              conn.out.size() - conn.out_off);
+            if (n < 0) {
+                if (errno == EAGAIN) {
+                    break;
+                }
+                Lost(idx);
+                return;
+            }
+            conn.out_off += n;
+        }
+        if (conn.out_off == conn.out.size()) {
+            conn.out.clear();
+            conn.out_off = 0;
+        }
+        SetWrite(idx, !conn.out.empty());
+    }
+
+    void OnReadable(size_t idx) {
+        char buf[64 * 1024];
+        const int fd = conns_[idx].fd;
+        // 解析中连接可能被重新建立（服务器声明关闭连接），此时停止读取
+        while (conns_[idx].fd == fd && !conns_[idx].connecting) {
+            Conn& conn = conns_[idx];
+            ssize_t n = read(conn.fd, buf, sizeof(buf));
+            if (n > 0) {
+                stats_.bytes += n;
+                conn.in.append(buf, n);
+                Parse(idx);
+            } else if (n == 0) {
+                // 响应体直到连接关闭
+                if (conn.until_close && !conn.inflight.empty()) {
+                    Complete(idx);
+                    if (conns_[idx].connecting) {
+                        return;
+                    }
+                }
+                Lost(idx);
+                return;
+            } else {
+                if (errno != EAGAIN) {
+                    Lost(idx);
+                }
+                return;
+            }
+        }
+    }
+
+    // 解析读到的响应，响应体不保存，只跳过
+    void Parse(size_t idx) {
+        Conn& conn = conns_[idx];
+        while (conn.fd >= 0 && !conn.connecting) {
+            if (conn.body_left < 0) {
+                size_t pos = conn.in.find("\r\n\r\n", conn.in_off);
+                if (pos == std::string::npos) {
+                    break;
+                }
+                ParseHead(conn, std::string_view(conn.in).substr(conn.in_off, pos - conn.in_off));
+                conn.in_off = pos + 4;
+            }
+            size_t avail = conn.in.size() - conn.in_off;
+            if (conn.until_close) {
+                conn.in_off += avail;
+                break;
+            }
+            size_t take = std::min<size_t>(avail, conn.body_left);
+            conn.in_off += take;
+            conn.body_left -= take;
+            if (conn.body_left > 0) {
+                break;
+            }
+            Complete(idx);
+        }
+        if (conn.in_off == conn.in.size()) {
+            conn.in.clear();
+            conn.in_off = 0;
+        } else if (conn.in_off > 64 * 1024) {
+            conn.in.erase(0, conn.in_off);
+            conn.in_off = 0;
+        }
+    }
+
+    void ParseHead(Conn& conn, std::string_view head) {
+        conn.status = 0;
+        if (head.size() >= 12 && head.compare(0, 5, "HTTP/") == 0) {
+            conn.status = atoi(std::string(head.substr(9, 3)).c_str());
+        }
+        conn.server_close = !opts_.keep_alive;
+        int64_t length = -1;
+        size_t pos = head.find("\r\n");
+        while (pos != std::string_view::npos) {
+            size_t next = head.find("\r\n", pos + 2);
+            std::string_view line = head.substr(pos + 2, next == std::string_view::npos
+                                                              ? std::string_view::npos
+                                                              : next - pos - 2);
+            size_t colon = line.find(':');
+            if (colon != std::string_view::npos) {
+                std::string_view name = line.substr(0, colon);
+                std::string_view value = line.substr(colon + 1);
+                while (!value.empty() && value.front() == ' ') {
+                    value.remove_prefix(1);
+                }
+                if (name.size() == 14 && strncasecmp(name.data(), "Content-Length", 14) == 0) {
+                    length = atoll(std::string(value).c_str());
+                } else if (name.size() == 10 && strncasecmp(name.data(), "Connection", 10) == 0 &&
+                           value.size() >= 5 && strncasecmp(value.data(), "close", 5) == 0) {
+                    conn.server_close = true;
+                }
+            }
+            pos = next;
+        }
+        bool no_body = conn.status == 204 || conn.status == 304 ||
+                       (conn.status >= 100 && conn.status < 200);
+        conn.until_close = !no_body && length < 0;
+        conn.body_left = no_body ? 0 : std::max<int64_t>(length, 0);
+    }
+
+    // 一个响应读取完毕
+    void Complete(size_t idx) {
+        Conn& conn = conns_[idx];
+        int64_t now = Now();
+        stats_.latency.Record((now - conn.inflight.front()) / 1000);
+        conn.inflight.pop_front();
+        ++stats_.completed;
+        ++stats_.status[conn.status >= 100 && conn.status < 600 ? conn.status / 100 : 0];
+        conn.body_left = -1;
+        conn.until_close = false;
+        if (conn.server_close) {
+            // 服务器声明关闭连接：剩下的请求重新排队，不计为错误
+            Reconnect(idx, false);
+            return;
+        }
+        Fill(idx);
+    }
+
+    // 连接意外断开：未完成的请求计为错误
+    void Lost(size_t idx) {
+        Reconnect(idx, true);
+    }
+
+    void Reconnect(size_t idx, bool failed) {
+        Conn& conn = conns_[idx];
+        if (failed) {
+            stats_.errors += conn.inflight.size();
+        } else if (interval_ > 0) {
+            for (auto it = conn.inflight.rbegin(); it != conn.inflight.rend(); ++it) {
+                pending_.push_front(*it);
+            }
+        } else {
+            stats_.sent -= conn.inflight.size();
+        }
+        Close(idx);
+        Connect(idx);
+    }
+
+    void Close(size_t idx) {
+        Conn& conn = conns_[idx];
+        if (conn.fd >= 0) {
+            epoll_ctl(epfd_, EPOLL_CTL_DEL, conn.fd, nullptr);
+            close(conn.fd);
+        }
+        conn = Conn();
+    }
+
+    static constexpr uint32_t kTimerIdx = UINT32_MAX;
+
+    const Options& opts_;
+    sockaddr_in addr_;
+    std::vector<Conn> conns_;
+    double interval_;  // 开环模式下相邻请求的间隔（单位：ns），0 表示闭环模式
+    int64_t next_send_ = 0;
+    std::deque<int64_t> pending_;  // 开环模式下已到期、等待空闲连接的请求
+    size_t rr_ = 0;
+    int epfd_ = -1;
+    int timerfd_ = -1;
+    int64_t armed_at_ = 0;
+    std::mt19937 rng_;
+    int total_weight_ = 0;
+    std::string requests_[static_cast<int>(RequestType::COUNT)];
+    Stats stats_;
+};
+
+bool ParseMix(const char* spec, Options* opts) {
+    std::fill(std::begin(opts->weights), std::end(opts->weights), 0);
+    std::string_view rest(spec);
+    while (!rest.empty()) {
+        size_t comma = rest.find(',');
+        std::string_view item = rest.substr(0, comma);
+        rest = comma == std::string_view::npos ? std::string_view() : rest.substr(comma + 1);
+        size_t eq = item.find('=');
+        std::string_view name = item.substr(0, eq);
+        int weight = eq == std::string_view::npos ? 1 : atoi(std::string(item.substr(eq + 1)).c_str());
+        int i = 0;
+        while (i < static_cast<int>(RequestType::COUNT) && name != kRequestTypeNames[i]) {
+            ++i;
+        }
+        if (i == static_cast<int>(RequestType::COUNT) || weight < 0) {
+            return false;
+        }
+        opts->weights[i] = weight;
+    }
+    int total = 0;
+    for (int w : opts->weights) {
+        total += w;
+    }
+    return total > 0;
+}
+
+void Usage(const char* prog) {
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  -H, --host HOST         server address (default 127.0.0.1)\n"
+            "  -p, --port PORT         server port (default 1027)\n"
+            "  -t, --threads N         worker threads (default 1)\n"
+            "  -c, --connections N     total connections (default 10)\n"
+            "  -d, --duration SEC      test duration (default 10)\n"
+            "  -D, --depth N           pipelined requests per connection (default 1)\n"
+            "  -r, --rate RPS          open-loop total request rate, 0 = closed loop (default 0)\n"
+            "  -m, --mix SPEC          request mix, e.g. static=9,login=1 (default static=1)\n"
+            "      --path PATH         path of static requests (default /index.html)\n"
+            "      --user NAME         login username (default alice)\n"
+            "      --password PWD      login password (default pw)\n"
+            "      --no-keepalive      one request per connection\n"
+            "      --json FILE         write results as JSON ('-' for stdout)\n",
+            prog);
+}
+
+bool ParseOptions(int argc, char** argv, Options* opts) {
+    enum { PATH = 256, USER, PASSWORD, NO_KEEPALIVE, JSON };
+    const option long_opts[] = {
+        {"host", required_argument, nullptr, 'H'},
+        {"port", required_argument, nullptr, 'p'},
+        {"threads", required_argument, nullptr, 't'},
+        {"connections", required_argument, nullptr, 'c'},
+        {"duration", required_argument, nullptr, 'd'},
+        {"depth", required_argument, nullptr, 'D'},
+        {"rate", required_argument, nullptr, 'r'},
+        {"mix", required_argument, nullptr, 'm'},
+        {"path", required_argument, nullptr, PATH},
+        {"user", required_argument, nullptr, USER},
+        {"password", required_argument, nullptr, PASSWORD},
+        {"no-keepalive", no_argument, nullptr, NO_KEEPALIVE},
+        {"json", required_argument, nullptr, JSON},
+        {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0},
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "H:p:t:c:d:D:r:m:h", long_opts, nullptr)) != -1) {
+        switch (opt) {
+            case 'H': opts->host = optarg; break;
+            case 'p': opts->port = atoi(optarg); break;
+            case 't': opts->threads = atoi(optarg); break;
+            case 'c': opts->connections = atoi(optarg); break;
+            case 'd': opts->duration = atof(optarg); break;
+            case 'D': opts->depth = atoi(optarg); break;
+            case 'r': opts->rate = atof(optarg); break;
+            case 'm':
+                if (!ParseMix(optarg, opts)) {
+                    fprintf(stderr, "invalid mix: %s\n", optarg);
+                    return false;
+                }
+                break;
+            case PATH: opts->path = optarg; break;
+            case USER: opts->user = optarg; break;
+            case PASSWORD: opts->password = optarg; break;
+            case NO_KEEPALIVE: opts->keep_alive = false; break;
+            case JSON: opts->json = optarg; break;
+            default: return false;
+        }
+    }
+    if (opts->threads < 1 || opts->connections < opts->threads || opts->depth < 1 ||
+        opts->duration <= 0 || opts->rate < 0 || opts->port <= 0) {
+        fprintf(stderr, "invalid options\n");
+        return false;
+    }
+    return true;
+}
+
+bool Resolve(const Options& opts, sockaddr_in* addr) {
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* res = nullptr;
+    if (getaddrinfo(opts.host.c_str(), nullptr, &hints, &res) != 0 || !res) {
+        return false;
+    }
+    *addr = *reinterpret_cast<sockaddr_in*>(res->ai_addr);
+    addr->sin_port = htons(opts.port);
+    freeaddrinfo(res);
+    return true;
+}
+
+void PrintText(const Options& opts, const Stats& stats, double elapsed) {
+    printf("target %s:%d, %d threads, %d connections, depth %d, keep-alive %s, ",
+           opts.host.c_str(), opts.port, opts.threads, opts.connections, opts.depth,
+           opts.keep_alive ? "on" : "off");
+    if (opts.rate > 0) {
+        printf("open loop at %.0f req/s\n", opts.rate);
+    } else {
+        printf("closed loop\n");
+    }
+    printf("%.2fs: %lu sent, %lu completed, %lu errors, %lu connects, %lu connect errors\n",
+           elapsed, stats.sent, stats.completed, stats.errors, stats.connects,
+           stats.connect_errors);
+    printf("throughput: %.1f req/s, %.2f MB/s\n", stats.completed / elapsed,
+           stats.bytes / elapsed / (1 << 20));
+    printf("status: 2xx %lu, 3xx %lu, 4xx %lu, 5xx %lu, other %lu\n", stats.status[2],
+           stats.status[3], stats.status[4], stats.status[5], stats.status[0] + stats.status[1]);
+    const Histogram& lat = stats.latency;
+    printf("latency (us): mean %.1f, p50 %lu, p90 %lu, p99 %lu, p999 %lu, max %lu\n",
+           lat.mean(), lat.Percentile(0.5), lat.Percentile(0.9), lat.Percentile(0.99),
+           lat.Percentile(0.999), lat.max());
+    if (opts.rate > 0) {
+        printf("max backlog: %lu requests\n", stats.max_backlog);
+    }
+}
+
+bool WriteJson(const Options& opts, const Stats& stats, double elapsed) {
+    FILE* fp = opts.json == "-" ? stdout : fopen(opts.json.c_str(), "w");
+    if (!fp) {
+        perror(opts.json.c_str());
+        return false;
+    }
+    const Histogram& lat = stats.latency;
+    fprintf(fp, "{\n  \"config\": {\"host\": \"%s\", \"port\": %d, \"threads\": %d, "
+                "\"connections\": %d, \"depth\": %d, \"keep_alive\": %s, \"rate\": %.0f, "
+                "\"duration\": %.3f, \"mix\": {",
+            opts.host.c_str(), opts.port, opts.threads, opts.connections, opts.depth,
+            opts.keep_alive ? "true" : "false", opts.rate, opts.duration);
+    for (int i = 0; i < static_cast<int>(RequestType::COUNT); ++i) {
+        fprintf(fp, "%s\"%s\": %d", i ? ", " : "", kRequestTypeNames[i], opts.weights[i]);
+    }
+    fprintf(fp, "}},\n");
+    fprintf(fp, "  \"elapsed\": %.3f,\n  \"sent\": %lu,\n  \"completed\": %lu,\n"
+                "  \"errors\": %lu,\n  \"connects\": %lu,\n  \"connect_errors\": %lu,\n"
+                "  \"max_backlog\": %lu,\n",
+            elapsed, stats.sent, stats.completed, stats.errors, stats.connects,
+            stats.connect_errors, stats.max_backlog);
+    fprintf(fp, "  \"throughput\": %.1f,\n  \"bytes_per_sec\": %.0f,\n",
+            stats.completed / elapsed, stats.bytes / elapsed);
+    fprintf(fp, "  \"status\": {\"2xx\": %lu, \"3xx\": %lu, \"4xx\": %lu, \"5xx\": %lu, "
+                "\"other\": %lu},\n",
+            stats.status[2], stats.status[3], stats.status[4], stats.status[5],
+            stats.status[0] + stats.status[1]);
+    fprintf(fp, "  \"latency_us\": {\"mean\": %.1f, \"p50\": %lu, \"p90\": %lu, \"p99\": %lu, "
+                "\"p999\": %lu, \"max\": %lu}\n}\n",
+            lat.mean(), lat.Percentile(0.5), lat.Percentile(0.9), lat.Percentile(0.99),
+            lat.Percentile(0.999), lat.max());
+    if (fp != stdout) {
+        fclose(fp);
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options opts;
+    if (!ParseOptions(argc, argv, &opts)) {
+        Usage(argv[0]);
+        return 1;
+    }
+    sockaddr_in addr;
+    if (!Resolve(opts, &addr)) {
+        fprintf(stderr, "cannot resolve %s\n", opts.host.c_str());
+        return 1;
+    }
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    for (int i = 0; i < opts.threads; ++i) {
+        int conn_num = opts.connections / opts.threads + (i < opts.connections % opts.threads);
+        workers.emplace_back(new Worker(opts, addr, conn_num, opts.rate / opts.threads, i + 1));
+    }
+    int64_t start = Now();
+    int64_t end = start + static_cast<int64_t>(opts.duration * 1e9);
+    std::vector<std::thread> threads;
+    for (auto& worker : workers) {
+        threads.emplace_back([&worker, start, end]() { worker->Run(start, end); });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    double elapsed = (Now() - start) / 1e9;
+
+    Stats stats;
+    for (auto& worker : workers) {
+        stats.Merge(worker->stats());
+    }
+    if (opts.json != "-") {
+        PrintText(opts, stats, elapsed);
+    }
+    if (!opts.json.empty() && !WriteJson(opts, stats, elapsed)) {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,164 @@
+// Author: Cukoo
+// Date: 2026-10-18
+
+// HttpRequest 解析器的吞吐量基准测试
+
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer.h"
+#include "http/httprequest.h"
+
+namespace {
+
+// 典型的请求报文：浏览器请求页面、请求图片、命令行工具请求、提交表单
+const std::vector<std::string> kCorpus = {
+    "GET /index.html HTTP/1.1\r\n"
+    "Host: www.example.com:1316\r\n"
+    "Connection: keep-alive\r\n"
+    "Cache-Control: max-age=0\r\n"
+    "sec-ch-ua: \"Chromium\";v=\"124\", \"Not-A.Brand\";v=\"99\"\r\n"
+    "sec-ch-ua-mobile: ?0\r\n"
+    "sec-ch-ua-platform: \"Linux\"\r\n"
+    "Upgrade-Insecure-Requests: 1\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 "
+    "(KHTML, like Gecko) Chrome/124.0.0.0 Safari/537.36\r\n"
+    "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,"
+    "image/avif,image/webp,*/*;q=0.8\r\n"
+    "Sec-Fetch-Site: none\r\n"
+    "Sec-Fetch-Mode: navigate\r\n"
+    "Sec-Fetch-User: ?1\r\n"
+    "Sec-Fetch-Dest: document\r\n"
+    "Accept-Encoding: gzip, deflate, br\r\n"
+    "Accept-Language: zh-CN,zh;q=0.9,en;q=0.8\r\n"
+    "\r\n",
+
+    "GET /images/profile-image.jpg HTTP/1.1\r\n"
+    "Host: www.example.com:1316\r\n"
+    "Connection: keep-alive\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:125.0) Gecko/20100101 "
+    "Firefox/125.0\r\n"
+    "Accept: image/avif,image/webp,*/*\r\n"
+    "Accept-Language: en-US,en;q=0.5\r\n"
+    "Accept-Encoding: gzip, deflate, br\r\n"
+    "Referer: http://www.example.com:1316/picture.html\r\n"
+    "\r\n",
+
+    "GET / HTTP/1.1\r\n"
+    "Host: 127.0.0.1:1316\r\n"
+    "User-Agent: curl/8.5.0\r\n"
+    "Accept: */*\r\n"
+    "\r\n",
+
+    "POST /submit HTTP/1.1\r\n"
+    "Host: www.example.com:1316\r\n"
+    "Connection: keep-alive\r\n"
+    "Content-Type: application/x-www-form-urlencoded\r\n"
+    "Content-Length: 43\r\n"
+    "Origin: http://www.example.com:1316\r\n"
+    "Referer: http://www.example.com:1316/login.html\r\n"
+    "\r\n"
+    "username=cukoo&password=p%40ss+word&keep=on",
+};
+
+// 每次迭代解析一个完整的请求报文
+void BM_ParseRequest(benchmark::State& state) {
+    const std::string& req = kCorpus[state.range(0)];
+    Buffer buff;
+    HttpRequest request;
+    for (auto _ : state) {
+        buff.Append(req);
+        request.Init();
+        auto result = request.Parse(buff);
+        benchmark::DoNotOptimize(result);
+        request.Retrieve(buff);
+    }
+    state.SetBytesProcessed(state.iterations() * req.size());
+}
+BENCHMARK(BM_ParseRequest)->DenseRange(0, kCorpus.size() - 1);
+
+// 数据分多次到达：每次追加 state.range(0) 个字节后调用一次 Parse
+void BM_ParsePartial(benchmark::State& state) {
+    const std::string& req = kCorpus[0];
+    const size_t chunk = state.range(0);
+    Buffer buff;
+    HttpRequest request;
+    for (auto _ : state) {
+        request.Init();
+        for (size_t off = 0; off < req.size(); off += chunk) {
+            buff.Append(req.data() + off, std::min(chunk, req.size() - off));
+            auto result = request.Parse(buff);
+            benchmark::DoNotOptimize(result);
+        }
+        request.Retrieve(buff);
+    }
+    state.SetBytesProcessed(state.iterations() * req.size());
+}
+BENCHMARK(BM_ParsePartial)->Arg(16)->Arg(64)->Arg(256);
+
+// 流水线：整个语料一次性到达，逐个解析
+void BM_ParsePipelined(benchmark::State& state) {
+    std::string all;
+    for (const std::string& req : kCorpus) {
+        all += req;
+    }
+    Buffer buff;
+    HttpRequest request;
+    for (auto _ : state) {
+        buff.Append(all);
+        while (buff.ReadableBytes() > 0) {
+            request.Init();
+            auto result = request.Parse(buff);
+            benchmark::DoNotOptimize(result);
+            request.Retrieve(buff);
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * all.size());
+}
+BENCHMARK(BM_ParsePipelined);
+
+// 请求体边接收边交给接收者：1MB 的请求体按 16KB（约为一次 ReadFd 读入的量）分段到达，
+// state.range(0) 为 0 时用 Content-Length，否则用分块传输，每块 state.range(0) 字节
+void BM_ParseStreamedBody(benchmark::State& state) {
+    const size_t chunk_size = state.range(0);
+    const size_t body_size = 1 << 20;
+    std::string req = "POST /upload HTTP/1.1\r\nHost: www.example.com:1316\r\n";
+    if (chunk_size == 0) {
+        req += "Content-Length: " + std::to_string(body_size) + "\r\n\r\n" +
+               std::string(body_size, 'x');
+    } else {
+        char size_line[32];
+        snprintf(size_line, sizeof(size_line), "%zx\r\n", chunk_size);
+        req += "Transfer-Encoding: chunked\r\n\r\n";
+        for (size_t sent = 0; sent < body_size; sent += chunk_size) {
+            req += size_line + std::string(chunk_size, 'x') + "\r\n";
+        }
+        req += "0\r\n\r\n";
+    }
+    const size_t piece = 16 * 1024;
+    size_t received = 0;
+    Buffer buff;
+    HttpRequest request;
+    // 请求体留在内存中，只测量解码，不测量落盘
+    const size_t spill_threshold = BodyStore::kSpillThreshold_;
+    BodyStore::kSpillThreshold_ = 2 * body_size;
+    for (auto _ : state) {
+        request.Init();
+        for (size_t off = 0; off < req.size(); off += piece) {
+            buff.Append(req.data() + off, std::min(piece, req.size() - off));
+            auto result = request.Parse(buff);
+            benchmark::DoNotOptimize(result);
+        }
+        received += request.body_store().size();
+        request.Retrieve(buff);
+    }
+    BodyStore::kSpillThreshold_ = spill_threshold;
+    benchmark::DoNotOptimize(received);
+    state.SetBytesProcessed(state.iterations() * req.size());
+}
+BENCHMARK(BM_ParseStreamedBody)->Arg(0)->Arg(1024)->Arg(16 * 1024);
+
+}  // namespace
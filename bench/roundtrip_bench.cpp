@@ -0,0 +1,90 @@
+// Author: Cukoo
+// Date: 2026-10-18
+
+// 进程内的请求往返：客户端通过 socketpair 发送请求，HttpConn 读取、解析、组装并发送响应，
+// 客户端读回完整的响应；以及 Epoller 每处理一个事件的开销（EPOLLONESHOT 模式下的 Wait + Modify）
+
+#include <benchmark/benchmark.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <string>
+
+#include "http/filecache.h"
+#include "http/httpconn.h"
+#include "server/epoller.h"
+
+namespace {
+
+const char kRequest[] =
+    "GET /index.html HTTP/1.1\r\n"
+    "Host: 127.0.0.1:1027\r\n"
+    "Connection: keep-alive\r\n"
+    "Accept: */*\r\n"
+    "\r\n";
+
+void SetupServer() {
+    spdlog::set_level(spdlog::level::off);
+    HttpConn::kWorkDir_ = BENCH_RESOURCE_DIR;
+    HttpConn::kKeepAliveMax_ = 0;  // 同一个连接反复使用，不限制请求数
+    FileCache::Instance()->Init(1024, 1000, 64 * 1024);
+}
+
+// 每次迭代发送 state.range(0) 个流水线请求，读回全部响应
+void BM_SocketpairRoundTrip(benchmark::State& state) {
+    SetupServer();
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds) < 0) {
+        state.SkipWithError("socketpair failed");
+        return;
+    }
+    std::string requests;
+    for (int i = 0; i < state.range(0); ++i) {
+        requests += kRequest;
+    }
+    HttpConn conn;
+    conn.Init(fds[1], sockaddr_in{});
+    char buf[64 * 1024];
+    int save_errno = 0;
+    size_t bytes = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(write(fds[0], requests.data(), requests.size()));
+        conn.Read(&save_errno);
+        if (conn.Process() != HttpConn::ProcessResult::WRITE) {
+            state.SkipWithError("unexpected process result");
+            break;
+        }
+        conn.Write(&save_errno);
+        ssize_t n;
+        while ((n = read(fds[0], buf, sizeof(buf))) > 0) {
+            bytes += n;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetBytesProcessed(bytes);
+    conn.Close();
+    close(fds[0]);
+}
+BENCHMARK(BM_SocketpairRoundTrip)->Arg(1)->Arg(8);
+
+// 单 Reactor 模式下每个事件都要重新注册（EPOLLONESHOT）
+void BM_EpollerOneShot(benchmark::State& state) {
+    Epoller epoller;
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds) < 0) {
+        state.SkipWithError("setup failed");
+        return;
+    }
+    const uint32_t events = EPOLLOUT | EPOLLONESHOT;
+    epoller.Add(fds[0], events);
+    for (auto _ : state) {
+        int n = epoller.Wait(-1);
+        benchmark::DoNotOptimize(n);
+        epoller.Modify(fds[0], events);
+    }
+    epoller.Remove(fds[0]);
+    close(fds[0]);
+    close(fds[1]);
+}
+BENCHMARK(BM_EpollerOneShot);
+
+}  // namespace
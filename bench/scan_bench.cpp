@@ -0,0 +1,199 @@
+// Author: Cukoo
+// Date: 2026-10-18
+
+// ByteScan 的基准测试：在大的请求头、表单请求体上与原先的实现对比
+// 参数为实现：0、1 为对照（原先的表单解码、不做校验的 memchr），之后依次为 ByteScan 的 SCALAR、SSE2、AVX2
+
+#include <benchmark/benchmark.h>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+
+#include "buffer/buffer.h"
+#include "http/bytescan.h"
+#include "http/httprequest.h"
+
+namespace {
+
+constexpr int kBaselines = 2;
+
+const ByteScan::Isa kDefaultIsa = ByteScan::isa();
+
+// 约 8KB 的请求头：长的 Cookie、User-Agent 等
+std::string MakeHeaders() {
+    std::string headers;
+    for (int i = 0; headers.size() < 8 * 1024; ++i) {
+        headers += "X-Custom-Header-" + std::to_string(i) + ": ";
+        headers += std::string(40 + (i * 37) % 200, 'v') + "\r\n";
+        headers += "Cookie: session" + std::to_string(i) + "=" +
+                   std::string(60 + (i * 53) % 300, 'c') + "\r\n";
+    }
+    return headers;
+}
+
+// 约 4KB 的表单：少量的 %XX 转义和 '+'
+std::string MakeForm() {
+    std::string form;
+    for (int i = 0; form.size() < 4 * 1024; ++i) {
+        if (!form.empty()) {
+            form += '&';
+        }
+        form += "field" + std::to_string(i) + "=" +
+                std::string(20 + (i * 29) % 80, 'a') + "%40example+com" +
+                std::string(10 + (i * 13) % 40, 'b');
+    }
+    return form;
+}
+
+const std::string kHeaders = MakeHeaders();
+const std::string kForm = MakeForm();
+
+// 切换到参数指定的 ByteScan 实现，CPU 不支持时跳过
+bool UseIsa(benchmark::State& state, int impl) {
+    static const char* const kNames[] = {"scalar", "sse2", "avx2"};
+    int isa = impl - kBaselines;
+    if (!ByteScan::SetIsa(static_cast<ByteScan::Isa>(isa))) {
+        state.SkipWithError("unsupported instruction set");
+        return false;
+    }
+    state.SetLabel(kNames[isa]);
+    return true;
+}
+
+// 在每一行中找出（并校验）请求头名称
+void BM_HeaderNames(benchmark::State& state) {
+    const int impl = state.range(0);
+    if (impl >= kBaselines && !UseIsa(state, impl)) {
+        return;
+    }
+    if (impl == 1) {
+        state.SetLabel("memchr, no validation");
+    }
+    const char* begin = kHeaders.data();
+    const char* end = begin + kHeaders.size();
+    for (auto _ : state) {
+        int valid = 0;
+        for (const char* p = begin; p < end;) {
+            const char* eol = static_cast<const char*>(memchr(p, '\n', end - p));
+            const char* colon;
+            if (impl == 1) {
+                colon = static_cast<const char*>(memchr(p, ':', eol - p));
+            } else {
+                colon = ByteScan::FindNonToken(p, eol);
+            }
+            valid += colon && colon < eol && *colon == ':';
+            p = eol + 1;
+        }
+        benchmark::DoNotOptimize(valid);
+    }
+    ByteScan::SetIsa(kDefaultIsa);
+    state.SetBytesProcessed(state.iterations() * kHeaders.size());
+}
+BENCHMARK(BM_HeaderNames)->Arg(1)->DenseRange(kBaselines, kBaselines + 2);
+
+// 原先的 ParseFromUrlencoded：逐字节扫描，'%' 的解码结果是错误的
+void DecodeFormOld(const std::string& body,
+                   std::unordered_map<std::string, std::string>* parms) {
+    std::string data(body);
+    std::string key, value;
+    int n = data.size();
+    int i = 0, j = 0;
+    auto hex = [](char ch) -> int {
+        if (ch >= 'A' && ch <= 'F') return ch - 'A' + 10;
+        if (ch >= 'a' && ch <= 'f') return ch - 'a' + 10;
+        return ch;
+    };
+    for (; i < n; ++i) {
+        switch (data[i]) {
+            case '=':
+                key = data.substr(j, i - j);
+                j = i + 1;
+                break;
+            case '+':
+                data[i] = ' ';
+                break;
+            case '%': {
+                int num = hex(data[i + 1]) * 16 + hex(data[i + 2]);
+                data[i + 2] = num % 10 + '0';
+                data[i + 1] = num / 10 + '0';
+                i += 2;
+                break;
+            }
+            case '&':
+                value = data.substr(j, i - j);
+                j = i + 1;
+                (*parms)[key] = value;
+                break;
+            default:
+                break;
+        }
+    }
+    if (parms->count(key) == 0 && j < i) {
+        (*parms)[key] = data.substr(j, i - j);
+    }
+}
+
+// 与 HttpRequest::ParseFromUrlencoded 相同的解码过程
+void DecodeFormNew(const std::string& body,
+                   std::unordered_map<std::string, std::string>* parms) {
+    const char* p = body.data();
+    const char* end = p + body.size();
+    std::string key, value;
+    while (p < end) {
+        const char* amp = ByteScan::FindFirstOf(p, end, "&");
+        const char* eq = ByteScan::FindFirstOf(p, amp, "=");
+        if (eq != p) {
+            ByteScan::PercentDecode(std::string_view(p, eq - p), &key, true);
+            ByteScan::PercentDecode(
+                eq < amp ? std::string_view(eq + 1, amp - eq - 1) : std::string_view(),
+                &value, true);
+            (*parms)[key] = value;
+        }
+        p = amp < end ? amp + 1 : end;
+    }
+}
+
+void BM_FormDecode(benchmark::State& state) {
+    const int impl = state.range(0);
+    if (impl >= kBaselines && !UseIsa(state, impl)) {
+        return;
+    }
+    if (impl == 0) {
+        state.SetLabel("old, incorrect %XX");
+    }
+    std::unordered_map<std::string, std::string> parms;
+    for (auto _ : state) {
+        parms.clear();
+        if (impl == 0) {
+            DecodeFormOld(kForm, &parms);
+        } else {
+            DecodeFormNew(kForm, &parms);
+        }
+        benchmark::DoNotOptimize(parms.size());
+    }
+    ByteScan::SetIsa(kDefaultIsa);
+    state.SetBytesProcessed(state.iterations() * kForm.size());
+}
+BENCHMARK(BM_FormDecode)->Arg(0)->DenseRange(kBaselines, kBaselines + 2);
+
+// 完整地解析一个带有 8KB 请求头的请求报文
+void BM_ParseLargeHeaders(benchmark::State& state) {
+    if (!UseIsa(state, state.range(0))) {
+        return;
+    }
+    const std::string req = "GET /index.html HTTP/1.1\r\n" + kHeaders + "\r\n";
+    Buffer buff;
+    HttpRequest request;
+    for (auto _ : state) {
+        buff.Append(req);
+        request.Init();
+        auto result = request.Parse(buff);
+        benchmark::DoNotOptimize(result);
+        request.Retrieve(buff);
+    }
+    ByteScan::SetIsa(kDefaultIsa);
+    state.SetBytesProcessed(state.iterations() * req.size());
+}
+BENCHMARK(BM_ParseLargeHeaders)->DenseRange(kBaselines, kBaselines + 2);
+
+}  // namespace
@@ -0,0 +1,85 @@
+// Author: Cukoo
+// Date: 2026-10-18
+
+// ThreadPool 的基准测试：任务吞吐量、单个任务从提交到执行的延迟、工作线程投递给自己的任务
+
+#include <benchmark/benchmark.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "pool/threadpool.h"
+
+namespace {
+
+constexpr int kBatch = 10000;
+
+// 每次迭代从外部线程提交一批空任务，等待全部执行完
+void BM_ThreadPoolThroughput(benchmark::State& state) {
+    ThreadPool pool(state.range(0));
+    std::atomic<int> done{0};
+    for (auto _ : state) {
+        done.store(0, std::memory_order_relaxed);
+        for (int i = 0; i < kBatch; ++i) {
+            pool.AddTask([&done]() { done.fetch_add(1, std::memory_order_relaxed); });
+        }
+        while (done.load(std::memory_order_acquire) < kBatch) {
+            std::this_thread::yield();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * kBatch);
+}
+BENCHMARK(BM_ThreadPoolThroughput)->Arg(1)->Arg(4)->Arg(8)->UseRealTime();
+
+// 提交一个任务并等待它开始执行：线程池空闲时（工作线程可能已休眠）的延迟
+void BM_ThreadPoolLatency(benchmark::State& state) {
+    ThreadPool pool(state.range(0));
+    std::atomic<bool> ran{false};
+    for (auto _ : state) {
+        ran.store(false, std::memory_order_relaxed);
+        pool.AddTask([&ran]() { ran.store(true, std::memory_order_release); });
+        while (!ran.load(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+    }
+}
+BENCHMARK(BM_ThreadPoolLatency)->Arg(1)->Arg(8)->UseRealTime();
+
+// 工作线程投递给自己的任务：每个任务处理一块数据后投递下一个任务，处理同一块数据。
+// 下一个任务在同一个线程上紧接着执行时，数据仍在该 CPU 的缓存中
+void BM_ThreadPoolSelfSubmit(benchmark::State& state) {
+    ThreadPool pool(state.range(0));
+    constexpr int kChain = 1000;
+    struct Chain {
+        ThreadPool* pool;
+        std::atomic<int> left;
+        std::atomic<bool> done;
+        std::vector<uint64_t> data = std::vector<uint64_t>(512);  // 4KB
+        void Step() {
+            uint64_t sum = 0;
+            for (uint64_t& x : data) {
+                sum += ++x;
+            }
+            benchmark::DoNotOptimize(sum);
+            if (left.fetch_sub(1, std::memory_order_relaxed) > 1) {
+                pool->AddTask([this]() { Step(); });
+            } else {
+                done.store(true, std::memory_order_release);
+            }
+        }
+    };
+    Chain chain;
+    chain.pool = &pool;
+    for (auto _ : state) {
+        chain.left.store(kChain, std::memory_order_relaxed);
+        chain.done.store(false, std::memory_order_relaxed);
+        pool.AddTask([&chain]() { chain.Step(); });
+        while (!chain.done.load(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * kChain);
+}
+BENCHMARK(BM_ThreadPoolSelfSubmit)->Arg(1)->Arg(4)->Arg(8)->UseRealTime();
+
+}  // namespace
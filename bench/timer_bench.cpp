@@ -0,0 +1,101 @@
+// Author: Cukoo
+// Date: 2026-10-18
+
+// 定时器容器的基准测试：小根堆（TimerHeap）与分层时间轮（TimerWheel）
+
+#include <benchmark/benchmark.h>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "timer/timerheap.h"
+#include "timer/timerwheel.h"
+
+namespace {
+
+const int kTimeout = 60000;  // 单位：ms，测试期间不会有定时器到期
+
+// 预先生成的随机 id，避免在计时范围内调用随机数生成器
+std::vector<int> RandomIds(int n) {
+    std::mt19937 rng(42);
+    std::vector<int> ids(1 << 16);
+    for (int& id : ids) {
+        id = rng() % n;
+    }
+    return ids;
+}
+
+void NoopHandler(void*, TimerNode*) {}
+
+// 连接上每次有读写事件时都要刷新其定时器
+void BM_HeapTouch(benchmark::State& state) {
+    const int n = state.range(0);
+    TimerHeap heap;
+    for (int i = 0; i < n; ++i) {
+        heap.Add(i, kTimeout, []() {});
+    }
+    std::vector<int> ids = RandomIds(n);
+    size_t i = 0;
+    for (auto _ : state) {
+        heap.Adjust(ids[i++ & 0xffff], kTimeout);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_HeapTouch)->Arg(10000)->Arg(100000)->Arg(1000000);
+
+void BM_WheelTouch(benchmark::State& state) {
+    const int n = state.range(0);
+    std::vector<TimerNode> nodes(n);  // 结点要比时间轮活得更久
+    TimerWheel wheel(&NoopHandler, nullptr);
+    for (TimerNode& node : nodes) {
+        wheel.Schedule(&node, kTimeout);
+    }
+    std::vector<int> ids = RandomIds(n);
+    size_t i = 0;
+    for (auto _ : state) {
+        wheel.Schedule(&nodes[ids[i++ & 0xffff]], kTimeout);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_WheelTouch)->Arg(10000)->Arg(100000)->Arg(1000000);
+
+// 添加 n 个定时器，然后让它们全部到期
+void BM_HeapAddExpire(benchmark::State& state) {
+    const int n = state.range(0);
+    TimerHeap heap;
+    int fired = 0;
+    for (auto _ : state) {
+        for (int i = 0; i < n; ++i) {
+            heap.Add(i, 0, [&fired]() { ++fired; });
+        }
+        heap.Tick();
+    }
+    benchmark::DoNotOptimize(fired);
+    state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_HeapAddExpire)
+    ->Arg(10000)->Arg(100000)->Arg(1000000)->Unit(benchmark::kMillisecond);
+
+void BM_WheelAddExpire(benchmark::State& state) {
+    const int n = state.range(0);
+    int fired = 0;
+    std::vector<TimerNode> nodes(n);
+    TimerWheel wheel(
+        [](void* ctx, TimerNode*) { ++*static_cast<int*>(ctx); }, &fired);
+    for (auto _ : state) {
+        for (TimerNode& node : nodes) {
+            wheel.Schedule(&node, 0);
+        }
+        // 时间轮的精度为 1ms，等到下一毫秒定时器才会到期
+        state.PauseTiming();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        state.ResumeTiming();
+        wheel.Tick();
+    }
+    benchmark::DoNotOptimize(fired);
+    state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_WheelAddExpire)
+    ->Arg(10000)->Arg(100000)->Arg(1000000)->Unit(benchmark::kMillisecond);
+
+}  // namespace
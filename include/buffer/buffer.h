@@ -5,24 +5,32 @@
 #define BUFFER_H
 
 #include <assert.h>
+#include <errno.h>
 #include <sys/uio.h>
 #include <unistd.h>
-#include <atomic>
 #include <cstring>
-#include <iostream>
-#include <vector>
+#include <string>
 
+#include "buffer/chunkpool.h"
+
+// 由定长内存块（Chunk）串成的缓冲区
+// - 块从 ChunkPool 中按需取得，数据被全部取走后立即归还，空闲的连接不占用缓冲区内存
+// - 追加数据只会在链尾追加块，已有数据的地址不会改变
+// - 待读取的数据可能跨越多个块，需要连续访问时调用 Linearize 合并
 class Buffer {
    public:
-    Buffer(int init_buff_size = 1024);
-    ~Buffer() = default;
+    Buffer();
+    ~Buffer();
+
+    Buffer(const Buffer&) = delete;
+    Buffer& operator=(const Buffer&) = delete;
 
-    size_t PrependableBytes() const;
     size_t ReadableBytes() const;
-    size_t WritableBytes() const;
 
+    // 第一个块中待读取数据的起始地址，只有这个块中的数据是连续的
     const char* ReadBegin() const;
-    const char* ConstWriteBegin() const;
+    // 把待读取的数据合并到一个块中（已经只有一个块时什么也不做），返回其起始地址
+    const char* Linearize();
 
     void Retrieve(size_t len);
     void RetrieveUntil(const char* end);
@@ -35,17 +43,25 @@ class Buffer {
     ssize_t ReadFd(int fd, int* save_errno);
     ssize_t WriteFd(int fd, int* save_errno);
 
+    // 依次以 (地址, 长度) 访问各个块中待读取的数据，可用于组装 writev 的 iovec
+    template <typename F>
+    void ForEachChunk(F&& f) const {
+        for (const Chunk* chunk = head_; chunk; chunk = chunk->next) {
+            if (chunk->Readable() > 0) {
+                f(chunk->data() + chunk->read, chunk->Readable());
+            }
+        }
+    }
+
    private:
-    char* Begin();
-    const char* Begin() const;
-    char* WriteBegin();
-    void EnsureWritable(size_t len);
-    void MakeSpace(size_t len);
-    void HasWritten(size_t len);
-
-    std::vector<char> buffer_;
-    std::atomic<size_t> read_pos_;
-    std::atomic<size_t> write_pos_;
+    static constexpr int kReadChunks_ = 4;  // ReadFd 每次最多读入的新块数
+    static constexpr int kMaxIov_ = 16;     // WriteFd 每次最多写出的块数
+
+    void PushChunk(Chunk* chunk);
+
+    Chunk* head_;
+    Chunk* tail_;
+    size_t readable_;
 };
 
 #endif
@@ -0,0 +1,48 @@
+// Author: Cukoo
+// Date: 2026-10-18
+
+#ifndef CHUNK_POOL_H
+#define CHUNK_POOL_H
+
+#include <atomic>
+#include <cstddef>
+
+// 缓冲区链中的一个内存块，数据区紧跟在结构体之后
+struct Chunk {
+    Chunk* next;
+    size_t cap;    // 数据区的容量
+    size_t read;   // [read, write) 为待读取的数据
+    size_t write;
+
+    char* data() { return reinterpret_cast<char*>(this + 1); }
+    const char* data() const { return reinterpret_cast<const char*>(this + 1); }
+    size_t Readable() const { return write - read; }
+    size_t Writable() const { return cap - write; }
+};
+
+// 定长内存块的分配器
+// - 每个线程缓存一些空闲的块（单链表），分配、归还都不加锁，超出上限的块直接释放
+// - 块可以在一个线程中分配、在另一个线程中归还（单 Reactor 模式下连接由不同的工作线程处理）
+// - 大于定长的块（Buffer::Linearize 合并数据时）直接向堆申请，不缓存
+class ChunkPool {
+   public:
+    static constexpr size_t kChunkSize_ = 4096;  // 一个定长块占用的内存（包括结构体）
+    static constexpr size_t kCapacity_ = kChunkSize_ - sizeof(Chunk);
+
+    // 返回数据区容量不小于 min_cap 的空块
+    static Chunk* Get(size_t min_cap = kCapacity_);
+    static void Put(Chunk* chunk);
+
+    // 从堆中申请、尚未释放的块占用的字节数（包括各线程缓存的空闲块）
+    static size_t HeapBytes();
+
+   private:
+    static constexpr size_t kMaxCached_ = 256;  // 每个线程最多缓存的空闲块数
+
+    static Chunk* Allocate(size_t cap);
+    static void Free(Chunk* chunk);
+
+    static std::atomic<size_t> heap_bytes_;
+};
+
+#endif
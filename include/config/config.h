@@ -8,11 +8,30 @@
 #include <filesystem>
 #include <spdlog/spdlog.h>
 
+// 多 Reactor 模式下，新连接分发给 Reactor 的策略
+enum class DispatchPolicy {
+    ROUND_ROBIN,  // 轮流分发
+    LEAST_LOAD,   // 分发给连接数最少的 Reactor
+    INCOMING_CPU  // 按 SO_INCOMING_CPU 分发给接收该连接数据包的 CPU 上（或同一 NUMA 结点上）的 Reactor
+};
+
+// 静态文件的压缩方式（按 Accept-Encoding 协商）
+enum class Compression {
+    PRECOMPRESSED,  // 只发送已有的 .br、.gz 文件
+    ON_DEMAND,      // 没有 .br、.gz 文件时，首次访问时压缩并缓存
+    AT_STARTUP      // 同上，并在启动时预先压缩工作目录中的所有文本文件
+};
+
 struct Config {
     std::string work_dir = std::filesystem::current_path().string() + "/resources";
     int port = 1027;
     bool enable_linger = true;
-    int timeout = 10000;    // 单位：ms
+    int timeout = 10000;    // 单位：ms，空闲（等待下一个请求）的超时，不大于 0 时不设任何超时；通过 Keep-Alive 告知客户
+    int keep_alive_requests = 100;  // 一个连接最多处理的请求数，0 表示不限制
+    int header_timeout = 10000;  // 单位：ms，从开始接收请求到收完请求头的最长时间，收到数据不会延后；新连接同样
+    int body_timeout = 30000;    // 单位：ms，接收请求体时两次收到数据之间的最长间隔
+    int write_timeout = 30000;   // 单位：ms，发送响应时两次写出数据之间的最长间隔
+    int max_fd = 65536;     // 连接表大小，fd 不小于该值的连接会被拒绝
     const char* host = "localhost";
     int sql_port = 3306;
     const char* sql_user = "root";
@@ -20,7 +39,26 @@ struct Config {
     const char* db_name = "webserver";
     int sql_conn_pool_size = 8;
     int thread_pool_size = 8;
-    spdlog::level::level_enum log_level = spdlog::level::off;
+    int reactor_num = 0;    // Reactor 线程数，0 表示单 Reactor + 线程池模式
+    DispatchPolicy dispatch_policy = DispatchPolicy::ROUND_ROBIN;
+    const char* reactor_cpus = nullptr;  // Reactor 线程绑定的 CPU 列表（如 "0-3,8"），第 i 个 Reactor 绑定到第 i 个 CPU（循环使用），nullptr 表示不绑定
+    const char* worker_cpus = nullptr;   // 线程池工作线程绑定的 CPU 列表，规则同上
+    long sendfile_threshold = 64 * 1024;  // 单位：字节，不小于该值的文件用 sendfile 发送，负数表示始终用 mmap
+    int file_cache_capacity = 1024;       // 缓存的文件数，0 表示不缓存
+    int file_cache_revalidate = 1000;     // 单位：ms，缓存的文件超过该时间后重新 stat 校验
+    Compression compression = Compression::PRECOMPRESSED;
+    int user_cache_capacity = 4096;       // 缓存的用户记录数，0 表示不缓存（每次登录、注册都查询数据库）
+    int user_cache_ttl = 60000;           // 单位：ms，用户记录（包括不存在的用户名）缓存的时间
+    const char* metrics_path = "/metrics";  // Prometheus 指标页面的路径，nullptr 表示不提供
+    const char* access_log = nullptr;      // 访问日志的路径，nullptr 表示不记录
+    size_t max_start_line = 8 * 1024;     // 单位：字节，请求行的最大长度，超过时响应 414
+    int max_headers = 100;                // 请求头的最大个数，超过时响应 431
+    size_t max_header_bytes = 32 * 1024;  // 单位：字节，请求头（不含请求行）的最大总长度，超过时响应 431
+    size_t max_body_size = 1 << 30;       // 单位：字节，请求体的最大长度，超过时响应 413，0 表示不限制
+    size_t read_budget = 256 * 1024;      // 单位：字节，一个连接每次读事件最多读入的数据量，0 表示读到不能再读
+    size_t body_spill_threshold = 64 * 1024;  // 单位：字节，超过该长度的请求体写入临时文件
+    const char* body_spill_dir = "/tmp";      // 请求体临时文件所在的目录
+    spdlog::level::level_enum log_level = spdlog::level::off;  // 低于编译期级别（SPDLOG_ACTIVE_LEVEL）的日志已被移除
 };
 
 #endif
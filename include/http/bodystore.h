@@ -0,0 +1,57 @@
+// Author: Cukoo
+// Date: 2026-10-18
+
+#ifndef BODY_STORE_H
+#define BODY_STORE_H
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// 请求体的接收者：不超过 kSpillThreshold_ 时保存在内存中，
+// 超过后把已有的内容连同之后的数据写入临时文件（落盘），连接占用的内存不随请求体增长
+class BodyStore {
+   public:
+    BodyStore();
+    ~BodyStore();
+
+    BodyStore(const BodyStore&) = delete;
+    BodyStore& operator=(const BodyStore&) = delete;
+
+    // 丢弃保存的内容（关闭临时文件），准备接收下一个请求体
+    void Clear();
+    // 连接关闭时调用：除临时文件外，管道和保留的内存也一并释放
+    void Reset();
+
+    // 追加一段请求体，落盘失败时返回 false
+    bool Append(const char* data, size_t len);
+
+    // 从 fd（socket）中读至多 len 字节，经管道 splice 到临时文件中，数据不经过用户态
+    // 只能在已落盘后调用；返回值与 read 相同
+    ssize_t Splice(int fd, size_t len, int* save_errno);
+
+    bool IsSpilled() const;
+    // 内存中的内容，已落盘时为空
+    std::string_view data() const;
+    // 临时文件的 fd（读写位置在末尾），未落盘时为 -1
+    int fd() const;
+    size_t size() const;
+
+    static size_t kSpillThreshold_;  // 单位：字节
+    static std::string kSpillDir_;   // 临时文件所在的目录
+
+   private:
+    bool Spill();
+    bool WriteAll(const char* data, size_t len);
+
+    static constexpr size_t kKeepCapacity_ = 4096;  // Clear 时保留的内存容量
+
+    std::string mem_;
+    int fd_;
+    int pipe_[2];  // Splice 使用的管道，首次 Splice 时创建
+    size_t size_;
+};
+
+#endif
@@ -0,0 +1,42 @@
+// Author: Cukoo
+// Date: 2026-10-18
+
+#ifndef BYTE_SCAN_H
+#define BYTE_SCAN_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// 解析请求报文用到的字节扫描，每次比较 16（SSE2）或 32（AVX2）个字节
+// 首次使用时按 CPU 支持的指令集选择实现，非 x86 平台只有逐字节的实现
+class ByteScan {
+   public:
+    enum class Isa {
+        SCALAR,
+        SSE2,  // FindNonToken 需要 SSSE3 的 pshufb，不支持时退回逐字节查表
+        AVX2
+    };
+
+    // [begin, end) 中第一个属于 set（至多 4 个字节）的字节，没有时返回 end
+    // set 只有一个字节时直接使用 memchr，与所选的实现无关
+    static const char* FindFirstOf(const char* begin,
+                                   const char* end,
+                                   std::string_view set);
+
+    // 第一个不是 token 字符（RFC 9110 的 tchar）的字节，没有时返回 end
+    // 用于校验请求方法、请求头名称，请求头名称之后应当恰好是 ':'
+    static const char* FindNonToken(const char* begin, const char* end);
+
+    // 解码 %XX 转义（plus_as_space 时还把 '+' 解码为空格），结果写入 out
+    // 不完整或不合法的转义（如 "%4"、"%zz"）原样保留
+    static void PercentDecode(std::string_view in,
+                              std::string* out,
+                              bool plus_as_space);
+
+    static Isa isa();
+    // 切换实现（用于基准测试对比），CPU 不支持时返回 false
+    static bool SetIsa(Isa isa);
+};
+
+#endif
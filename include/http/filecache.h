@@ -0,0 +1,134 @@
+// Author: Cukoo
+// Date: 2026-10-18
+
+#ifndef FILE_CACHE_H
+#define FILE_CACHE_H
+
+#include <assert.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <spdlog/spdlog.h>
+
+#include "config/config.h"
+#include "pool/threadpool.h"
+
+// 响应体的内容编码
+enum class ContentEncoding {
+    IDENTITY,
+    GZIP,
+    BROTLI
+};
+
+// 缓存的文件：stat 的结果、文件类型，以及打开的 fd 或映射到内存的地址
+// 缓存项通过 shared_ptr 共享，被淘汰或失效后，正在发送它的响应仍然可以安全地使用它
+struct CachedFile {
+    CachedFile() = default;
+    ~CachedFile();
+    CachedFile(const CachedFile&) = delete;
+    CachedFile& operator=(const CachedFile&) = delete;
+
+    bool exists = false;  // stat 是否成功（不存在的文件同样会被缓存）
+    struct stat st = {};
+    std::string type;      // 根据文件名后缀推断的文件类型
+    std::string etag;      // 由 inode、大小、修改时间生成的强校验器
+    std::string last_modified;  // 修改时间（HTTP 日期）
+    void* addr = nullptr;  // 小文件映射到内存中的地址，或者指向 content
+    int fd = -1;           // 大文件保持打开，用 sendfile 发送
+    std::string content;   // 在内存中生成的内容（压缩结果），此时 st 来自源文件
+    off_t source_size = 0;  // 生成 content 时源文件的大小
+    mutable std::atomic<int64_t> checked_at{0};  // 上一次校验的时间（steady_clock，单位：ns）
+};
+
+// 按路径缓存文件，避免每个请求都 stat、open、mmap、munmap
+// - 分片的 LRU，每个分片各有一把锁，容量满时淘汰最久未使用的缓存项
+// - 缓存项超过校验间隔后重新 stat，mtime、大小或 inode 变化时重新加载
+// - 文本文件的压缩版本：优先使用预先压缩好的 .br、.gz 文件，也可以在内存中压缩并缓存
+class FileCache {
+   public:
+    static FileCache* Instance();
+
+    // capacity 为 0 时不缓存，每次都重新加载
+    // 不小于 sendfile_threshold 的文件保持打开，否则映射到内存中，负数表示始终映射
+    void Init(int capacity,
+              int revalidate_ms,
+              long sendfile_threshold,
+              Compression compression = Compression::PRECOMPRESSED);
+
+    std::shared_ptr<const CachedFile> Get(const std::string& path);
+    // 获取 origin（路径为 path）按 encoding 压缩的版本，没有时返回空（在内存中压缩的版本可能正在后台生成）
+    std::shared_ptr<const CachedFile> GetCompressed(
+        const std::string& path,
+        const std::shared_ptr<const CachedFile>& origin,
+        ContentEncoding encoding);
+    // 预先压缩 dir 中的所有文本文件（Compression::AT_STARTUP）
+    void Precompress(const std::string& dir);
+
+    static bool IsCompressible(const std::string& type);
+    static bool IsEncodingSupported(ContentEncoding encoding);
+
+    uint64_t hits() const;
+    uint64_t misses() const;
+
+   private:
+    using Entry = std::pair<std::string, std::shared_ptr<CachedFile>>;
+
+    struct Shard {
+        std::mutex mtx;
+        std::list<Entry> lru;  // 表头为最近使用的缓存项
+        std::unordered_map<std::string, std::list<Entry>::iterator> index;
+        std::unordered_set<std::string> compressing;  // 正在压缩的键
+    };
+
+    FileCache() = default;
+    ~FileCache() = default;
+
+    Shard& GetShard(const std::string& key);
+    std::shared_ptr<CachedFile> Find(Shard& shard, const std::string& key);
+    std::shared_ptr<CachedFile> Load(const std::string& path) const;
+    // best 为 true 时在当前线程中以最高的压缩级别压缩（启动时预先压缩），否则在后台以中等级别压缩
+    std::shared_ptr<const CachedFile> GetCompressed(
+        const std::string& path,
+        const std::shared_ptr<const CachedFile>& source,
+        ContentEncoding encoding,
+        bool best);
+    std::shared_ptr<CachedFile> Compress(const CachedFile& origin,
+                                         ContentEncoding encoding,
+                                         bool best) const;
+    void Insert(Shard& shard,
+                const std::string& key,
+                const std::shared_ptr<CachedFile>& file);
+    static bool IsSame(const CachedFile& file, bool exists, const struct stat& st);
+    static std::string GetFileType(const std::string& path);
+    static int64_t Now();
+
+    static constexpr size_t kShardNum_ = 16;
+    static constexpr off_t kMinCompressSize_ = 256;  // 小于该大小的文件不值得压缩
+
+    size_t shard_capacity_ = 0;
+    int64_t revalidate_ns_ = 0;
+    long sendfile_threshold_ = 64 * 1024;
+    Compression compression_ = Compression::PRECOMPRESSED;
+    Shard shards_[kShardNum_];
+
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+
+    // 在内存中压缩的后台线程（不为 PRECOMPRESSED 时才创建），最先析构，之后任务不再访问分片
+    std::unique_ptr<ThreadPool> compress_pool_;
+
+    static const std::unordered_map<std::string, std::string>
+        kSuffixTypes_;  // 文件名后缀 -> 文件类型
+};
+
+#endif
@@ -6,19 +6,43 @@
 
 #include <arpa/inet.h>
 #include <errno.h>
+#include <limits.h>
 #include <stdlib.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
 #include <sys/types.h>
 #include <sys/uio.h>
 #include <atomic>
+#include <memory>
+#include <vector>
 #include <spdlog/spdlog.h>
 
 #include "http/httprequest.h"
 #include "http/httpresponse.h"
-#include "pool/sqlconnguard.h"
+#include "log/accesslog.h"
 #include "buffer/buffer.h"
+#include "timer/timerwheel.h"
 
 class HttpConn {
    public:
+    // Process 的结果，指示接下来该做什么
+    enum class ProcessResult {
+        WRITE,     // 有待发送的响应
+        READ,      // 请求报文不完整，需要继续读
+        VERIFY,    // 遇到登录、注册请求，调用者须发起验证，完成后调用 FinishVerify
+        VERIFYING  // 正在等待验证结果，暂不处理该连接
+    };
+
+    // 连接当前所处的阶段，决定适用哪一个超时（见 Reactor::Deadline）
+    enum class Phase {
+        CONNECTED,  // 刚建立，尚未收到任何数据
+        IDLE,       // 等待下一个请求
+        HEADERS,    // 正在接收请求行、请求头
+        BODY,       // 正在接收请求体
+        WRITE,      // 正在发送响应
+        VERIFY      // 正在等待验证结果
+    };
+
     HttpConn();
 
     ~HttpConn();
@@ -31,33 +55,92 @@ class HttpConn {
 
     void Close();
 
+    bool IsClosed() const;
+
     int sockfd() const;
 
+    uint32_t generation() const;
+
+    uint64_t tag() const;
+
     int port() const;
 
     const char* ip() const;
 
     sockaddr_in addr() const;
 
-    bool Process();
+    ProcessResult Process();
+
+    void FinishVerify(bool ok);
+
+    const HttpRequest& request() const;
 
     int ToWriteBytes();
 
     bool IsKeepAlive() const;
 
+    // 挂起中，等待登录、注册的验证结果（FinishVerify 之前）
+    bool IsVerifying() const;
+
+    TimerNode* timer_node();
+
+    // 以下由 Reactor 线程读取，用于判断连接是否超时（时刻的单位：ms，见 TimerWheel::Now）
+    Phase phase() const;
+    int64_t phase_since() const;  // 进入当前阶段的时刻
+    int64_t last_read() const;    // 最后一次读到数据的时刻
+    int64_t last_write() const;   // 最后一次写出数据的时刻
+
+    // 上一次 Read 因用完读预算而提前停止，socket 中可能还有数据，需要由调用者安排再读
+    bool IsReadPaused() const;
+
+    // 单 Reactor 模式下，Reactor 把该连接交给工作线程前调用 BeginTask，工作线程处理完后调用 EndTask
+    // IsBusy 为 true 时工作线程可能正在使用该连接，Reactor 不能关闭它（否则 fd 可能被复用、槽位被重新 Init）
+    void BeginTask();
+    void EndTask();
+    bool IsBusy() const;
+
+    // 接收请求超时：尽力发送 408 响应（不阻塞，发不出去就算了），之后由调用者关闭连接
+    void SendRequestTimeout();
+
     static std::string kWorkDir_;
+    static size_t kReadBudget_;  // 单位：字节，每次 Read 最多读入的数据量，0 表示不限制
+    static int kKeepAliveMax_;   // 一个连接最多处理的请求数，0 表示不限制
     static std::atomic<int> client_count_;
 
    private:
+    void AddResponse(HttpRequest::ParseResult http_code);
+    void SendContinue();
+    ssize_t WriteMemory();
+    void Advance(size_t len);
+    void ClearResponses();
+    void UpdatePhase();
+
+    static constexpr int kMaxPipelineDepth_ = 16;  // 一次最多处理的流水线请求数
+
     int sockfd_;
+    std::atomic<uint32_t> generation_;  // 每次 Init 递增，用于识别 fd 复用前的过期事件和定时器
     sockaddr_in addr_;
-    bool is_closed_;
-    int iov_cnt_;
-    iovec iov_[2];
+    std::atomic<bool> is_closed_;
+    bool is_keep_alive_;  // 最后一个响应是否保持连接
+    bool is_verifying_;   // 挂起中，等待 request_ 的验证结果
+    bool read_paused_;
+    std::atomic<Phase> phase_;
+    std::atomic<int64_t> phase_since_;
+    std::atomic<int64_t> last_read_;
+    std::atomic<int64_t> last_write_;
+    std::atomic<int> busy_tasks_;  // 已交给工作线程、尚未处理完的任务数，Init 时不清零
+    int response_cnt_;
+    int request_cnt_;  // 该连接已处理的请求数
+    size_t header_lens_[kMaxPipelineDepth_];  // 各个响应的响应头长度
+    size_t seg_idx_;  // 第一个尚未写完的数据段
+    size_t to_write_bytes_;
+    std::vector<BodySegment> segments_;  // 依次为各个响应的响应头、响应体
+    std::vector<iovec> iov_;         // writev 时使用的临时数组
     Buffer read_buff_;
-    Buffer write_buff_;
+    Buffer write_buff_;  // 依次存放各个响应的响应头
     HttpRequest request_;
-    HttpResponse response_;
+    std::unique_ptr<HttpResponse[]> responses_;  // 待发送的响应，按请求的顺序排列
+    TimerNode timer_node_;  // 超时定时器，由所属 Reactor 的时间轮管理
 };
 
 #endif
\ No newline at end of file
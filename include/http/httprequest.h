@@ -5,16 +5,19 @@
 #define HTTP_REQUEST_H
 
 #include <errno.h>
-#include <mysql/mysql.h>
-#include <regex>
+#include <time.h>
+#include <functional>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 #include <spdlog/spdlog.h>
 
 #include "buffer/buffer.h"
-#include "pool/sqlconnguard.h"
-#include "pool/sqlconnpool.h"
+#include "http/bodystore.h"
+#include "http/bytescan.h"
+#include "http/usercache.h"
 
 class HttpRequest {
    public:
@@ -22,8 +25,9 @@ class HttpRequest {
     enum class ParseState {
         START_LINE,
         HEADERS,
-        BODY,
-        FINISH
+        BODY,    // 边接收边把请求体交给接收者
+        FINISH,
+        ERROR    // 出错，之后的数据不再解析
     };
 
     // 指示解析结果的枚举
@@ -33,45 +37,133 @@ class HttpRequest {
         ERROR     // 出错（请求报文格式有误）
     };
 
+    // Range 中的一个区间，first 为 -1 时表示最后 last 个字节（如 "bytes=-500"），
+    // last 为 -1 时表示直到文件末尾（如 "bytes=9500-"）
+    struct ByteRange {
+        int64_t first;
+        int64_t last;
+    };
+
+    // 请求体的处理函数，请求体分段到达时按顺序调用（在 BodyStore 保存、落盘之前），
+    // 返回 false 表示出错（请求报文视为有误）。调用时请求行、请求头都已解析完毕，可以通过 HttpRequest 访问
+    using BodyHandler = std::function<bool(const char* data, size_t len)>;
+
     HttpRequest();
     ~HttpRequest() = default;
 
     void Init();
+    // 连接关闭时调用：释放请求体占用的临时文件、管道和内存，清除请求体的处理函数
+    void Release();
 
     std::string url() const;
     std::string& url();
-    std::string method() const;
-    std::string version() const;
+    std::string_view method() const;
+    std::string_view version() const;
+    std::string_view body() const;
+    std::string_view GetHeader(std::string_view name) const;
     ParseState state() const;
+    // 解析出错时应当响应的状态码：格式有误为 400，超出限制为 413、414、431
+    int error_code() const;
     bool IsKeepAlive() const;
+    bool AcceptsEncoding(std::string_view coding) const;
+    bool GetRanges(std::vector<ByteRange>* ranges) const;
+    bool IsNotModified(std::string_view etag, time_t mtime) const;
+    bool NeedsVerify() const;
+    bool IsLogin() const;
+    void SetVerifyResult(bool ok);
     std::string GetPostRequestParm(const std::string& key) const;
 
+    // 设置之后的请求的请求体处理函数（Init 不会清除，Release 会清除），nullptr 表示不设置
+    // 设置后请求体总是边接收边处理，不会留在读缓冲区中，也不会由 SpliceBody 直接写入临时文件
+    void SetBodyHandler(BodyHandler handler);
+    // 边接收边处理的请求体，落盘时 body() 为空，须从临时文件中读取
+    const BodyStore& body_store() const;
+    // 客户在等待 100 Continue：每个请求只返回一次 true
+    bool TakeExpectContinue();
+    // 正在接收的请求体可以由 SpliceBody 从 socket 直接写入临时文件（已落盘，读缓冲区中没有剩余）
+    bool CanSpliceBody(const Buffer& buff) const;
+    ssize_t SpliceBody(int fd, int* save_errno);
+
     ParseResult Parse(Buffer& buff);
+    void Retrieve(Buffer& buff);
+
+    static bool ParseHttpDate(std::string_view value, time_t* t);
+
+    // 请求报文各部分的长度限制（来自 Config），超出时尽早停止解析并报告错误
+    static size_t kMaxStartLine_;
+    static size_t kMaxHeaderBytes_;
+    static size_t kMaxHeaders_;
+    static size_t kMaxBodySize_;  // 0 表示不限制
 
    private:
-    bool ParseStartLine(const std::string& line);
-    bool ParseHeaders(const std::string& line);
-    bool ParseBody(const std::string& line);
+    // 报文中的一段，以相对于读缓冲区 ReadBegin() 的偏移量表示，不拷贝数据
+    struct Field {
+        uint32_t off = 0;
+        uint32_t len = 0;
+    };
+
+    struct Header {
+        Field name;
+        Field value;
+    };
+
+    // 分块传输（Transfer-Encoding: chunked）的请求体解析到哪一部分
+    enum class ChunkState {
+        SIZE,      // 块大小行
+        DATA,      // 块数据
+        DATA_END,  // 块数据之后的空行
+        TRAILER    // 最后一个块之后的 trailer，直到空行
+    };
+
+    ParseResult Fail(int code = 400);
+    bool ParseStartLine(const char* begin, const char* end);
+    bool ParseHeader(const char* begin, const char* end);
+    bool ParseContentLength();
+    void StartBody(Buffer& buff);
+    ParseResult ParseBody(Buffer& buff);
+    bool ParseChunkLine(std::string_view line, bool* done);
+    bool ConsumeBody(Buffer& buff, size_t len);
+    void FinishParse();
+    bool HasConnectionOption(std::string_view option) const;
 
     void ParseUrl();
     void ParsePost();
     void ParseFromUrlencoded();
 
-    static bool UserVerify(const std::string& name,
-                           const std::string& pwd,
-                           bool is_login);
+    std::string_view View(Field field) const;
+    Field ToField(const char* begin, const char* end) const;
 
     ParseState state_;
-    std::string method_;
-    std::string url_;
-    std::string version_;
-    std::string body_;
-    std::unordered_map<std::string, std::string> headers_;
+    const Buffer* buff_;  // 正在解析的读缓冲区，请求报文被取走前，各个 Field 都指向其中
+    size_t line_begin_;   // 当前行的起始偏移
+    size_t scan_pos_;     // 已扫描到的偏移，数据分多次到达时从这里继续扫描
+    size_t headers_off_;  // 请求头的起始偏移（请求行之后）
+    size_t content_length_;
+    size_t body_total_;  // 分块传输时已收到的请求体长度
+    size_t body_left_;  // 请求体（分块传输时为当前块）尚未收到的字节数
+    bool is_chunked_;
+    ChunkState chunk_state_;
+    bool expects_continue_;
+    int error_code_;
+    bool is_keep_alive_;
+    bool needs_verify_;  // 登录、注册请求，须等待验证结果后才能确定 url
+    bool is_login_;
+
+    Field method_;
+    Field version_;
+    Field body_;
+    std::string url_;  // url 会被改写（如补全 .html），因此单独保存
+    // 边接收边处理请求体时，请求行、请求头被复制到这里，之后各个 Field 都指向其中
+    std::string head_;
+    std::string line_;  // 分块传输时跨越读缓冲区多个块的一行
+    std::vector<Header> headers_;
     std::unordered_map<std::string, std::string> post_request_parms_;
+    BodyHandler body_handler_;
+    BodyStore body_store_;
 
     static const std::unordered_set<std::string> kDefaultHtml_;
     static const std::unordered_map<std::string, int> kDefaultHtmlTag_;
-    static int ConvertHexToDecimal(char ch);  
+    static constexpr size_t kMaxChunkLine_ = 4096;  // 块大小行、trailer 的最大长度
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -4,14 +4,27 @@
 #ifndef HTTP_RESPONSE_H
 #define HTTP_RESPONSE_H
 
-#include <fcntl.h>
-#include <sys/mman.h>
 #include <sys/stat.h>
-#include <unistd.h>
+#include <atomic>
+#include <memory>
+#include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 #include <spdlog/spdlog.h>
 
 #include "buffer/buffer.h"
+#include "http/filecache.h"
+#include "http/httprequest.h"
+#include "metrics/metrics.h"
+
+// 响应体的一段：内存中的数据，或者文件中的一个区间（用 sendfile 发送）
+struct BodySegment {
+    const char* data;  // 内存段的地址，为空表示文件段
+    int fd;            // 文件段的 fd
+    off_t offset;      // 文件段的当前偏移，由 sendfile 推进
+    size_t len;        // 剩余字节数
+};
 
 class HttpResponse {
    public:
@@ -21,31 +34,51 @@ class HttpResponse {
     void Init(const std::string& work_dir,
               std::string& file_path,
               bool is_keep_alive = false,
-              int code = -1);
-    void MakeResponse(Buffer& buff);
-    void UnmapFile();
+              int code = -1,
+              int keep_alive_left = 0);
+    void MakeResponse(Buffer& buff, const HttpRequest& request);
+    void AppendBody(std::vector<BodySegment>* segments) const;
+    void ReleaseFile();
 
-    void* file_addr() const;
     size_t file_size() const;
+    size_t body_size() const;
     std::string file_type() const;
     int code() const;
 
+    static std::string kMetricsPath_;  // 指标页面的路径，为空表示不提供
+    static int kKeepAliveTimeout_;     // 单位：s，通过 Keep-Alive 告诉客户的空闲超时，0 表示不告知
+
    private:
     void AddStartLine(Buffer& buff);
     void AddHeaders(Buffer& buff);
     void AddBody(Buffer& buff);
     void HandleErrorStatusCode();
+    void NegotiateEncoding(const HttpRequest& request);
+    void HandleRange(const HttpRequest& request);
+    bool IsIfRangeMatched(const HttpRequest& request) const;
+    void AppendFileWindow(off_t offset,
+                          size_t len,
+                          std::vector<BodySegment>* segments) const;
     void ErrorContent(Buffer& buff, std::string message);
 
+    static std::shared_ptr<const CachedFile> MakeMetricsPage();
+
     int code_;
     bool is_keep_alive_;
+    int keep_alive_left_;  // 该连接还能处理的请求数，0 表示不限制
     std::string file_path_;  // 文件路径
     std::string work_dir_;  // 工作目录
-    void* file_addr_;  // 文件的内存地址
-    struct stat file_stat_;     // 文件的状态
+    std::shared_ptr<const CachedFile> file_;  // 文件（状态、类型、内存地址或 fd），来自 FileCache
+    std::string file_type_;  // 原始文件的类型（file_ 可能是压缩版本）
+    const char* content_encoding_;  // 为空表示未压缩
+    std::string etag_;  // 所发送的表示的实体标签，压缩版本带有编码后缀
+    bool vary_encoding_;  // 响应内容是否随 Accept-Encoding 变化
+    std::vector<std::pair<off_t, size_t>> ranges_;  // 206 响应要发送的文件区间（偏移，长度）
+    std::vector<std::string> part_heads_;  // 多区间响应中各部分之前的分隔行和头部，最后一个为结束分隔行
+    std::string boundary_;  // 多区间响应的分隔符
+
+    static constexpr size_t kMaxRanges_ = 16;  // 区间过多时忽略 Range，发送整个文件
 
-    static const std::unordered_map<std::string, std::string>
-        kSuffixTypes_;  // 文件名后缀 -> 文件类型
     static const std::unordered_map<int, std::string>
         kStatusCodePhrases_;  // 状态码 -> 短语
     static const std::unordered_map<int, std::string>
@@ -0,0 +1,86 @@
+// Author: Cukoo
+// Date: 2026-10-18
+
+#ifndef USER_CACHE_H
+#define USER_CACHE_H
+
+#include <assert.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <spdlog/spdlog.h>
+
+// 按用户名缓存用户记录，挡在 UserVerifyTask 前面：重复的登录、用已被占用的用户名注册
+// 直接在解析请求时得出结果，不必借用数据库连接
+// - 分片的 LRU，每个分片各有一把锁，缓存项超过 TTL 后失效（数据库被外部修改时最多延迟 TTL）
+// - 只保存密码的摘要（HMAC-SHA256，密钥在进程启动时随机生成），不保存明文
+// - 负缓存：不存在的用户名同样被缓存，登录时直接失败；注册时仍须写入数据库
+// - 没有 OpenSSL 时不保存摘要，只缓存用户名是否存在
+class UserCache {
+   public:
+    // 查询结果
+    enum class Result {
+        MISS,  // 须查询数据库
+        PASS,  // 登录成功
+        FAIL   // 用户不存在或密码错误（登录），用户名已被使用（注册）
+    };
+
+    static UserCache* Instance();
+
+    // capacity 为 0 时不缓存
+    void Init(int capacity, int ttl_ms);
+
+    Result Verify(const std::string& name, const std::string& pwd, bool is_login);
+    // 数据库中存在的用户（查询结果或注册成功后写入）
+    void PutUser(const std::string& name, std::string_view pwd);
+    // 数据库中不存在的用户名
+    void PutUnknown(const std::string& name);
+
+    uint64_t hits() const;
+    uint64_t misses() const;
+
+   private:
+    static constexpr size_t kDigestSize_ = 32;
+
+    struct Record {
+        bool exists = false;
+        bool has_digest = false;
+        unsigned char digest[kDigestSize_] = {};
+        int64_t expires_at = 0;  // steady_clock，单位：ns
+    };
+
+    using Entry = std::pair<std::string, Record>;
+
+    struct Shard {
+        std::mutex mtx;
+        std::list<Entry> lru;  // 表头为最近使用的缓存项
+        std::unordered_map<std::string, std::list<Entry>::iterator> index;
+    };
+
+    UserCache();
+    ~UserCache() = default;
+
+    Shard& GetShard(const std::string& name);
+    void Put(const std::string& name, const Record& record);
+    bool Digest(std::string_view pwd, unsigned char* out) const;
+    static int64_t Now();
+
+    static constexpr size_t kShardNum_ = 16;
+
+    size_t shard_capacity_ = 0;
+    int64_t ttl_ns_ = 0;
+    bool has_key_ = false;
+    unsigned char key_[kDigestSize_] = {};
+    Shard shards_[kShardNum_];
+
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+};
+
+#endif
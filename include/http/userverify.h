@@ -0,0 +1,68 @@
+// Author: Cukoo
+// Date: 2026-10-18
+
+#ifndef USER_VERIFY_H
+#define USER_VERIFY_H
+
+#include <assert.h>
+#include <sys/epoll.h>
+#include <mysql/mysql.h>
+#include <cstdint>
+#include <string>
+#include <spdlog/spdlog.h>
+
+#include "http/usercache.h"
+#include "pool/sqlconnpool.h"
+
+// 一次登录或注册验证：查询用户，注册且用户名未被使用时再插入新用户
+// UserCache 未命中时才会创建，查询、注册的结果写回 UserCache
+// 使用连接上预先准备好的语句，用户名、密码只作为参数绑定，不会被拼接进 SQL 文本
+// 任务持有借来的数据库连接，完成或销毁时归还给连接池。两种执行方式：
+// - Run：阻塞地执行全部语句，在 SqlConnPool 的专用线程中调用，结束时即归还连接
+// - Continue：基于 MariaDB 的非阻塞 API，由事件循环在 MySQL socket 就绪时反复调用，
+//   客户端库只有阻塞 API 时退化为 Run
+class UserVerifyTask {
+   public:
+    UserVerifyTask(uint64_t tag,
+                   const std::string& name,
+                   const std::string& pwd,
+                   bool is_login);
+    ~UserVerifyTask();
+    UserVerifyTask(const UserVerifyTask&) = delete;
+    UserVerifyTask& operator=(const UserVerifyTask&) = delete;
+
+    void SetConn(SqlConn* conn);
+    void Run();
+    uint32_t Continue(uint32_t events);
+
+    int fd() const;
+    uint64_t tag() const;
+    bool result() const;
+
+   private:
+    // 验证进行到哪一步（状态机），Run 和 Continue 共用
+    enum class Step {
+        SELECT,
+        STORE_RESULT,
+        INSERT,
+        FINISH
+    };
+
+    SqlStatement* CurrentStmt() const;
+    void BindParams(SqlStatement* stmt) const;
+    void NextStep();
+    bool CheckUser() const;
+    void ReleaseConn();
+
+    uint64_t tag_;  // 等待验证结果的连接（HttpConn::tag）
+    std::string name_;
+    std::string pwd_;
+    bool is_login_;
+    SqlConn* conn_;
+    Step step_;
+    bool is_waiting_;  // 当前一步已经开始，正在等待 MySQL socket 就绪
+    bool ok_;          // 上一步是否成功
+    bool result_;
+};
+
+#endif
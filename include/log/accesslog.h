@@ -0,0 +1,109 @@
+// Author: Cukoo
+// Date: 2026-10-18
+
+#ifndef ACCESS_LOG_H
+#define ACCESS_LOG_H
+
+#include <netinet/in.h>
+#include <time.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// 访问日志，每个响应一行（Common Log Format）
+// - 热路径只把定长的二进制记录写入当前线程自己的环形缓冲区（单生产者单消费者，无锁），
+//   不格式化、不做系统调用；缓冲区满时丢弃记录并计数，从不阻塞
+// - 后台线程定期取走所有缓冲区中的记录，格式化后批量写入文件
+class AccessLog {
+   public:
+    static AccessLog* Instance();
+
+    // path 为 nullptr 时不记录
+    void Init(const char* path);
+    // 停止后台线程，写完缓冲区中剩余的记录
+    void Close();
+
+    static void Log(const sockaddr_in& addr,
+                    std::string_view method,
+                    std::string_view url,
+                    std::string_view version,
+                    int code,
+                    size_t bytes) {
+        AccessLog* log = Instance();
+        if (log->is_open_.load(std::memory_order_relaxed)) {
+            log->Append(Local(), addr, method, url, version, code, bytes);
+        }
+    }
+
+    uint64_t dropped();
+
+   private:
+    static constexpr size_t kRingSize_ = 4096;  // 每个线程的缓冲区可存放的记录数，须为 2 的幂
+    static constexpr size_t kMaxUrlLen_ = 88;   // 超出的部分被截断
+    static constexpr size_t kFlushBytes_ = 64 * 1024;  // 格式化后的内容达到该长度时写入一次
+    static constexpr int kIntervalMs_ = 10;  // 后台线程的轮询间隔
+
+    // 一个请求的记录，格式化推迟到后台线程
+    struct Record {
+        int64_t time;  // 秒
+        uint64_t bytes;
+        uint32_t ip;
+        uint16_t code;
+        uint8_t url_len;
+        char method[8];   // 不足 8 字节时以 '\0' 结尾
+        char version[8];  // 同上
+        char url[kMaxUrlLen_];
+    };
+    static_assert(sizeof(Record) == 128, "a record should fill two cache lines");
+
+    // 一个线程的环形缓冲区，head 只由后台线程写入，tail 只由所属线程写入
+    struct Ring {
+        alignas(64) std::atomic<uint64_t> head{0};
+        alignas(64) std::atomic<uint64_t> tail{0};
+        uint64_t cached_head = 0;  // 所属线程上次读到的 head，满了才重新读取
+        std::atomic<uint64_t> dropped{0};
+        Record records[kRingSize_];
+    };
+
+    AccessLog() = default;
+    ~AccessLog();
+
+    static Ring& Local() {
+        thread_local Ring* ring = Instance()->NewRing();
+        return *ring;
+    }
+
+    void Append(Ring& ring,
+                const sockaddr_in& addr,
+                std::string_view method,
+                std::string_view url,
+                std::string_view version,
+                int code,
+                size_t bytes);
+    Ring* NewRing();
+    void Run();
+    void Drain(std::string* out);
+    void Format(const Record& record, std::string* out);
+    void Flush(std::string* out);
+
+    std::atomic<bool> is_open_{false};
+    int fd_ = -1;
+    bool stop_ = false;
+    std::mutex mtx_;
+    std::condition_variable cond_;
+    std::thread writer_;
+    // 线程退出后其缓冲区仍然保留，本项目的线程都是常驻的
+    std::vector<std::unique_ptr<Ring>> rings_;
+
+    // 以下只由后台线程访问：同一秒内的记录复用格式化好的时间
+    int64_t last_time_ = -1;
+    char time_buf_[32];
+};
+
+#endif
@@ -0,0 +1,140 @@
+// Author: Cukoo
+// Date: 2026-10-18
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <assert.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// 计数器（只增不减）
+enum class Counter {
+    ACCEPTS,            // 接受的连接
+    REJECTS,            // 因连接数已满而拒绝的连接
+    REQUESTS,           // 组装的响应
+    BYTES_WRITTEN,      // 发送的字节数
+    TIMER_EXPIRATIONS,  // 因超时而关闭的连接
+    COUNT
+};
+
+// 耗时的分布（单位：ns）
+enum class Histogram {
+    TASK_WAIT,        // 任务在线程池中排队的时间
+    PARSE,            // 每次调用 HttpRequest::Parse 的时间
+    FILE_LOOKUP,      // FileCache 查找（包括未命中时加载）的时间
+    SQL_BORROW_WAIT,  // 借用数据库连接的等待时间
+    COUNT
+};
+
+// 指标的注册表，以 Prometheus 的文本格式导出
+// - 热路径上的记录只写当前线程自己的槽（按缓存行对齐），不加锁、不与其他线程竞争缓存行，
+//   导出时才把各个线程的槽累加起来
+// - 直方图按 2 的幂分组、每组再分为 4 个桶（与 HdrHistogram 类似，相对误差不超过 25%），
+//   导出时合并为以 2 的幂为上界的桶
+// - 连接数、缓存命中次数等已经在别处维护的值，注册为回调，导出时求值
+class Metrics {
+   public:
+    // 回调指标的类型
+    enum class Type {
+        COUNTER,
+        GAUGE
+    };
+
+    static Metrics* Instance();
+
+    static void Add(Counter counter, uint64_t n = 1) {
+        Increase(Local().counters[static_cast<int>(counter)], n);
+    }
+
+    static void Observe(Histogram histogram, int64_t ns) {
+        HistogramData& data = Local().histograms[static_cast<int>(histogram)];
+        uint64_t value = ns > 0 ? ns : 0;
+        // 按 value - 1 分桶：桶的区间为左开右闭，恰好等于 2^exp 的值计入上界为 2^exp 的桶
+        Increase(data.buckets[BucketIndex(value > 0 ? value - 1 : 0)], 1);
+        Increase(data.count, 1);
+        Increase(data.sum, value);
+    }
+
+    static int64_t Now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    // name 不带前缀，如 "active_connections"
+    void AddCallback(const std::string& name,
+                     const std::string& help,
+                     Type type,
+                     std::function<double()> callback);
+    // 回调引用的对象销毁前须移除
+    void ClearCallbacks();
+
+    std::string Export();
+
+   private:
+    static constexpr int kSubBits_ = 3;  // 小于 2^kSubBits_ 的值各占一个桶
+    static constexpr uint64_t kHalf_ = 1ull << (kSubBits_ - 1);  // 每组的桶数
+    static constexpr size_t kBucketNum_ = (64 - kSubBits_ + 1) * kHalf_ + kHalf_;
+
+    struct HistogramData {
+        std::atomic<uint64_t> buckets[kBucketNum_];
+        std::atomic<uint64_t> count;
+        std::atomic<uint64_t> sum;
+    };
+
+    // 一个线程的槽，只有该线程写入
+    struct alignas(64) ThreadSlot {
+        std::atomic<uint64_t> counters[static_cast<int>(Counter::COUNT)];
+        HistogramData histograms[static_cast<int>(Histogram::COUNT)];
+    };
+
+    struct Callback {
+        std::string name;
+        std::string help;
+        Type type;
+        std::function<double()> fn;
+    };
+
+    Metrics() = default;
+    ~Metrics() = default;
+
+    static ThreadSlot& Local() {
+        thread_local ThreadSlot* slot = Instance()->NewSlot();
+        return *slot;
+    }
+
+    // 只有本线程写入，不需要原子的读-改-写
+    static void Increase(std::atomic<uint64_t>& value, uint64_t n) {
+        value.store(value.load(std::memory_order_relaxed) + n,
+                    std::memory_order_relaxed);
+    }
+
+    static size_t BucketIndex(uint64_t value) {
+        if (value < (1ull << kSubBits_)) {
+            return value;
+        }
+        int shift = 63 - __builtin_clzll(value) - (kSubBits_ - 1);
+        return shift * kHalf_ + (value >> shift);
+    }
+
+    ThreadSlot* NewSlot();
+
+    std::mutex mtx_;
+    // 线程退出后其槽仍然保留（计数器不能倒退），本项目的线程都是常驻的
+    std::vector<std::unique_ptr<ThreadSlot>> slots_;
+    std::vector<Callback> callbacks_;
+
+    static const char* const kCounterNames_[];
+    static const char* const kCounterHelps_[];
+    static const char* const kHistogramNames_[];
+    static const char* const kHistogramHelps_[];
+};
+
+#endif
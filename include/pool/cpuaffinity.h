@@ -0,0 +1,28 @@
+// Author: Cukoo
+// Date: 2026-10-18
+
+#ifndef CPU_AFFINITY_H
+#define CPU_AFFINITY_H
+
+#include <string>
+#include <vector>
+
+// 线程绑定 CPU、查询 CPU 所在的 NUMA 结点
+// 本项目不依赖 libnuma：内核默认按首次访问（first touch）在线程所在的结点上分配物理页，
+// 线程先绑定 CPU、再分配并初始化自己的数据，这些数据就位于本地结点上
+class CpuAffinity {
+   public:
+    // 解析 CPU 列表，格式与 taskset -c 相同，如 "0-3,8,10-11"；为空或格式错误时返回空列表
+    static std::vector<int> Parse(const char* list);
+
+    // 将当前线程绑定到 cpu 上
+    static bool Pin(int cpu);
+
+    // cpu 所在的 NUMA 结点，无法确定时返回 -1
+    static int NodeOf(int cpu);
+
+    // 可能存在的 CPU 数（包括离线的）
+    static int CpuCount();
+};
+
+#endif
@@ -0,0 +1,119 @@
+// Author: Cukoo
+// Date: 2026-10-18
+
+#ifndef SQL_CONN_H
+#define SQL_CONN_H
+
+#include <assert.h>
+#include <mysql/mysql.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+// 预处理语句：准备一次，之后每次只绑定参数执行，参数不会被拼接进 SQL 文本
+// - 参数按 ? 的顺序绑定，字符串参数在执行完成前须保持有效（不拷贝）
+// - 结果列统一以字符串取出，每列最多 kMaxColumnSize_ 字节，超出部分被截断
+class SqlStatement {
+   public:
+    explicit SqlStatement(const char* query);
+    ~SqlStatement();
+    SqlStatement(const SqlStatement&) = delete;
+    SqlStatement& operator=(const SqlStatement&) = delete;
+
+    bool Prepare(MYSQL* sql);
+    void Close();
+
+    void Bind(size_t idx, std::string_view value);
+    void Bind(size_t idx, int64_t value);
+
+    bool Execute();
+    bool StoreResult();
+#ifdef WITH_MYSQL_NONBLOCKING
+    // 非阻塞 API：返回非 0 时须等待 MySQL socket 就绪后调用对应的 *Cont，ok 为执行结果
+    int ExecuteStart(bool* ok);
+    int ExecuteCont(bool* ok, int ready);
+    int StoreResultStart(bool* ok);
+    int StoreResultCont(bool* ok, int ready);
+#endif
+    bool Fetch();
+    void FreeResult();
+
+    std::string_view GetString(size_t col) const;
+    int64_t GetInt(size_t col) const;
+    unsigned int error() const;
+
+   private:
+    // MySQL 8 与 MariaDB 中 MYSQL_BIND::is_null 的类型不同（bool 或 my_bool）
+    using BindFlag = std::remove_pointer_t<decltype(MYSQL_BIND::is_null)>;
+
+    struct Param {
+        unsigned long length = 0;
+        long long value = 0;  // 整数参数
+    };
+
+    struct Column {
+        char data[256];
+        unsigned long length = 0;
+        BindFlag is_null = 0;
+        BindFlag error = 0;
+    };
+
+    bool BindParams();
+
+    static constexpr size_t kMaxColumnSize_ = sizeof(Column::data);
+
+    const char* query_;
+    MYSQL_STMT* stmt_;
+    std::vector<MYSQL_BIND> param_binds_;
+    std::vector<Param> params_;
+    std::vector<MYSQL_BIND> result_binds_;
+    std::unique_ptr<Column[]> columns_;
+};
+
+// 连接池中的一个连接：MySQL 连接，以及在其上预先准备好的语句
+// 执行中出现客户端错误（连接断开等）时标记为已断开，由连接池在归还时重新连接并重新准备所有语句
+class SqlConn {
+   public:
+    // 预先准备的语句
+    enum class Stmt {
+        SELECT_USER,  // 按用户名查询用户名及密码
+        INSERT_USER,  // 注册新用户
+        COUNT
+    };
+
+    SqlConn(const char* host,
+            int port,
+            const char* user,
+            const char* pwd,
+            const char* db_name);
+    ~SqlConn();
+    SqlConn(const SqlConn&) = delete;
+    SqlConn& operator=(const SqlConn&) = delete;
+
+    bool Connect();
+    void CheckError(const SqlStatement& stmt);
+
+    SqlStatement* stmt(Stmt which);
+    MYSQL* sql() const;
+    bool IsBroken() const;
+
+   private:
+    void Disconnect();
+
+    std::string host_;
+    int port_;
+    std::string user_;
+    std::string pwd_;
+    std::string db_name_;
+    MYSQL* sql_;
+    bool is_broken_;
+    std::unique_ptr<SqlStatement> stmts_[static_cast<int>(Stmt::COUNT)];
+
+    static const char* const kStmtQueries_[];
+};
+
+#endif
@@ -7,27 +7,48 @@
 #include <mysql/mysql.h>
 #include <string>
 #include <queue>
+#include <vector>
 #include <mutex>
-#include <condition_variable>
+#include <functional>
+#include <memory>
 #include <thread>
 #include <spdlog/spdlog.h>
 
+#include "pool/sqlconn.h"
+#include "pool/threadpool.h"
+
 class SqlConnPool {
     public:
+    using ConnCallback = std::function<void(SqlConn*)>;
+
     static SqlConnPool* Instance();
 
-    MYSQL* BorrowConn();
-    void ReturnConn(MYSQL* sql);
+    void BorrowConnAsync(ConnCallback callback);
+    void ReturnConn(SqlConn* conn);
+    void RunBlocking(Task task);
+
+    size_t FreeConnCount();
+    size_t WaiterCount();
 
     void Init(const char* host, int port, const char* user, const char* pwd, const char* db_name, int size = 8);
 
     private:
+    // 排队的异步借用者，记录开始等待的时刻用于统计等待时间
+    struct Waiter {
+        ConnCallback callback;
+        int64_t since;
+    };
+
     SqlConnPool() = default;
     ~SqlConnPool();
 
-    std::queue<MYSQL*> conns_que_;
+    void Release(SqlConn* conn);
+
+    std::vector<std::unique_ptr<SqlConn>> conns_;  // 所有连接
+    std::queue<SqlConn*> conns_que_;                // 空闲的连接
+    std::queue<Waiter> waiters_;       // 等待空闲连接的异步借用者
     std::mutex mtx_;
-    std::condition_variable cv_;
+    std::unique_ptr<ThreadPool> blocking_pool_;  // 执行阻塞查询（没有非阻塞 API 时）和重新连接的专用线程
 
 };
 
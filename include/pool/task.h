@@ -0,0 +1,96 @@
+// Author: Cukoo
+// Date: 2026-10-17
+
+#ifndef TASK_H
+#define TASK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// 固定大小的任务类型（类似 std::function<void()>），可调用对象直接存放在内部缓冲区中，
+// 不会发生堆内存分配。过大的可调用对象会在编译期报错。
+// 另外记录任务被投递的时刻，用于统计任务排队的时间
+class Task {
+   public:
+    static constexpr size_t kStorageSize = 48;
+
+    Task() = default;
+
+    template <typename F,
+              typename = std::enable_if_t<
+                  !std::is_same_v<std::decay_t<F>, Task>>>
+    Task(F&& f) {
+        using Fn = std::decay_t<F>;
+        static_assert(sizeof(Fn) <= kStorageSize, "task is too large");
+        static_assert(alignof(Fn) <= alignof(std::max_align_t),
+                      "task is over-aligned");
+        static_assert(std::is_nothrow_move_constructible_v<Fn>,
+                      "task must be nothrow move constructible");
+        new (storage_) Fn(std::forward<F>(f));
+        ops_ = &kOps<Fn>;
+    }
+
+    Task(Task&& that) noexcept { MoveFrom(that); }
+
+    Task& operator=(Task&& that) noexcept {
+        if (this != &that) {
+            Reset();
+            MoveFrom(that);
+        }
+        return *this;
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task() { Reset(); }
+
+    explicit operator bool() const { return ops_ != nullptr; }
+
+    void operator()() { ops_->invoke(storage_); }
+
+    int64_t enqueued_at() const { return enqueued_at_; }
+    void set_enqueued_at(int64_t t) { enqueued_at_ = t; }
+
+    void Reset() {
+        if (ops_) {
+            ops_->destroy(storage_);
+            ops_ = nullptr;
+        }
+    }
+
+   private:
+    struct Ops {
+        void (*invoke)(void*);
+        void (*move)(void* dst, void* src);
+        void (*destroy)(void*);
+    };
+
+    template <typename Fn>
+    static constexpr Ops kOps = {
+        [](void* p) { (*static_cast<Fn*>(p))(); },
+        [](void* dst, void* src) {
+            new (dst) Fn(std::move(*static_cast<Fn*>(src)));
+            static_cast<Fn*>(src)->~Fn();
+        },
+        [](void* p) { static_cast<Fn*>(p)->~Fn(); },
+    };
+
+    void MoveFrom(Task& that) {
+        enqueued_at_ = that.enqueued_at_;
+        ops_ = that.ops_;
+        if (ops_) {
+            ops_->move(storage_, that.storage_);
+            that.ops_ = nullptr;
+        }
+    }
+
+    alignas(std::max_align_t) unsigned char storage_[kStorageSize];
+    const Ops* ops_ = nullptr;
+    int64_t enqueued_at_ = 0;  // steady_clock，单位：ns
+};
+
+#endif
@@ -5,63 +5,343 @@
 #define THREAD_DATA_H
 
 #include <assert.h>
+#include <atomic>
 #include <condition_variable>
-#include <functional>
+#include <cstdint>
+#include <deque>
+#include <memory>
 #include <mutex>
-#include <queue>
 #include <thread>
+#include <vector>
+#include <spdlog/spdlog.h>
 
+#include "metrics/metrics.h"
+#include "pool/cpuaffinity.h"
+#include "pool/task.h"
+
+// 有界无锁任务队列（Vyukov MPMC），支持多个生产者和多个消费者
+// 工作线程从自己的队列中取任务，也可以从其他工作线程的队列中窃取任务
+class TaskQueue {
+   public:
+    explicit TaskQueue(size_t capacity) : mask_(capacity - 1) {
+        assert(capacity >= 2 && (capacity & (capacity - 1)) == 0);
+        cells_.reset(new Cell[capacity]);
+        for (size_t i = 0; i < capacity; ++i) {
+            cells_[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // 队列已满时返回 false，此时 task 保持不变
+    bool Push(Task& task) {
+        Cell* cell;
+        size_t pos = tail_.load(std::memory_order_relaxed);
+        while (true) {
+            cell = &cells_[pos & mask_];
+            size_t seq = cell->seq.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) -
+                            static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (tail_.compare_exchange_weak(pos, pos + 1,
+                                                std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+        cell->task = std::move(task);
+        cell->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 队列为空时返回 false
+    bool Pop(Task& task) {
+        Cell* cell;
+        size_t pos = head_.load(std::memory_order_relaxed);
+        while (true) {
+            cell = &cells_[pos & mask_];
+            size_t seq = cell->seq.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) -
+                            static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (head_.compare_exchange_weak(pos, pos + 1,
+                                                std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+        task = std::move(cell->task);
+        cell->seq.store(pos + mask_ + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 队列中的任务数（近似值，与 Push、Pop 并发时不精确）
+    size_t Size() const {
+        size_t head = head_.load(std::memory_order_relaxed);
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        return tail > head ? tail - head : 0;
+    }
+
+   private:
+    struct Cell {
+        std::atomic<size_t> seq;
+        Task task;
+    };
+
+    const size_t mask_;
+    std::unique_ptr<Cell[]> cells_;
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+};
+
+// 工作窃取线程池
+// - 每个工作线程有自己的无锁任务队列，外部线程投递的任务轮流分发，空闲的线程会从其他队列中窃取任务（FIFO）
+// - 工作线程投递的任务先放入自己的 LIFO 槽，当前任务结束后紧接着执行，数据还在该 CPU 的缓存中；
+//   被挤出 LIFO 槽的任务进入自己的队列，可以被其他线程窃取
+// - 任务类型为 Task，不会为 (WebServer*, HttpConn*) 这类小的可调用对象分配堆内存
+// - 没有任务时工作线程在各自的条件变量上休眠，投递任务时只唤醒一个休眠的线程
+// - 可以将工作线程依次绑定到 cpus 中的 CPU 上（循环使用），此时各线程的队列在绑定后由线程自己分配，
+//   位于该 CPU 所在的 NUMA 结点上
 class ThreadPool {
    public:
-    explicit ThreadPool(int size = 8) {
+    explicit ThreadPool(int size = 8, const std::vector<int>& cpus = {})
+        : workers_(size) {
+        assert(size > 0);
         for (int i = 0; i < size; ++i) {
-            threads_.emplace_back([&]() -> void {
-                std::unique_lock<std::mutex> lck(mtx_);
-                while (true) {
-                    // 检查 tasks_ 和 is_shutdown_ 时必须加锁
-                    if (!tasks_.empty()) {
-                        auto task = tasks_.front();
-                        tasks_.pop();
-                        lck.unlock();
-                        task();
-                        lck.lock();
-                        continue;       // 优雅关闭的关键
-                    }
-                    if (is_shutdown_) {
-                        break;
-                    }
-                    // 如果两个条件都不满足，就在条件变量上等待
-                    cv_.wait(lck);
-                }
-            });
+            int cpu = cpus.empty() ? -1 : cpus[i % cpus.size()];
+            threads_.emplace_back([this, i, cpu]() -> void { Run(i, cpu); });
         }
+        WaitStarted();
     }
 
     ~ThreadPool() {
-        // 修改 is_shutdown_，然后通知所有线程，并逐个 join
-        std::unique_lock<std::mutex> lck(mtx_);
+        // 修改 is_shutdown_，然后唤醒所有线程，并逐个 join
+        // 线程会先处理完所有剩余任务再退出（优雅关闭）
         is_shutdown_ = true;
-        lck.unlock();
-        cv_.notify_all();
+        for (auto& worker : workers_) {
+            if (worker->is_sleeping.exchange(false)) {
+                --idle_cnt_;
+            }
+            Notify(*worker);
+        }
         for (auto& t : threads_) {
             t.join();
         }
     }
 
-    void AddTask(std::function<void()> task) {
-        // 修改 tasks_，然后通知一个线程
-        std::unique_lock<std::mutex> lck(mtx_);
-        tasks_.push(task);
-        lck.unlock();
-        cv_.notify_one();
+    template <typename F>
+    void AddTask(F&& f) {
+        Task task(std::forward<F>(f));
+        task.set_enqueued_at(Metrics::Now());
+        if (current_pool_ != this) {
+            // 其他线程投递的任务轮流分发
+            Enqueue(next_.fetch_add(1, std::memory_order_relaxed) % workers_.size(),
+                    task);
+            return;
+        }
+        // 工作线程投递的任务放入自己的 LIFO 槽，原来在槽中的任务放入自己的队列
+        Worker& self = *workers_[current_index_];
+        if (!self.lifo) {
+            self.lifo = std::move(task);
+            return;
+        }
+        std::swap(self.lifo, task);
+        Enqueue(current_index_, task);
+    }
+
+    // 排队中的任务数（近似值，不含 LIFO 槽中的任务）
+    size_t QueueSize() const {
+        size_t size = overflow_size_.load(std::memory_order_relaxed);
+        for (const auto& worker : workers_) {
+            size += worker->queue.Size();
+        }
+        return size;
     }
 
    private:
+    static constexpr size_t kQueueCapacity_ = 1024;
+    static constexpr int kSpinCount_ = 64;
+    // 连续从 LIFO 槽中取任务的次数上限，避免互相投递的任务一直占着 LIFO 槽，饿死队列中的任务
+    static constexpr int kMaxLifoStreak_ = 3;
+
+    struct alignas(64) Worker {
+        Worker() : queue(kQueueCapacity_) {}
+        TaskQueue queue;
+        Task lifo;            // LIFO 槽，只由所属线程访问
+        int lifo_streak = 0;  // 连续从 LIFO 槽中取任务的次数
+        std::atomic<bool> is_sleeping{false};
+        std::mutex mtx;
+        std::condition_variable cv;
+        bool is_notified = false;
+    };
+
+    // 从 target 开始放入第一个未满的队列，都满了则放入溢出队列，然后唤醒一个休眠的线程
+    void Enqueue(size_t target, Task& task) {
+        const size_t n = workers_.size();
+        bool pushed = false;
+        for (size_t i = 0; i < n && !pushed; ++i) {
+            pushed = workers_[(target + i) % n]->queue.Push(task);
+        }
+        if (!pushed) {
+            // 所有队列都满了，放入溢出队列
+            std::lock_guard<std::mutex> lck(overflow_mtx_);
+            overflow_.push_back(std::move(task));
+            ++overflow_size_;
+        }
+        // 与 Park 中的屏障配对：要么这里看到休眠的线程，要么休眠前的线程看到这个任务
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (idle_cnt_.load(std::memory_order_relaxed) > 0) {
+            WakeOne(target);
+        }
+    }
+
+    void Run(size_t idx, int cpu) {
+        if (cpu >= 0 && !CpuAffinity::Pin(cpu)) {
+            spdlog::warn("Failed to pin worker {} to CPU {}", idx, cpu);
+        }
+        workers_[idx].reset(new Worker());
+        {
+            std::lock_guard<std::mutex> lck(start_mtx_);
+            ++started_cnt_;
+        }
+        start_cv_.notify_all();
+        // 其他线程的 Worker 都分配好之后才能窃取任务
+        WaitStarted();
+        current_pool_ = this;
+        current_index_ = idx;
+        Worker& self = *workers_[idx];
+        Task task;
+        while (true) {
+            if (self.lifo) {
+                if (self.lifo_streak < kMaxLifoStreak_) {
+                    ++self.lifo_streak;
+                    task = std::move(self.lifo);
+                    RunTask(task);
+                    continue;
+                }
+                // 达到上限，把 LIFO 槽中的任务放到自己的队列末尾，先执行排在前面的任务
+                Enqueue(idx, self.lifo);
+            }
+            self.lifo_streak = 0;
+            // LIFO 槽只在执行任务时被填充，因此下面自旋和休眠时它一定是空的
+            if (TryGetTask(idx, task)) {
+                RunTask(task);
+                continue;
+            }
+            // 短暂自旋，避免任务稀疏时频繁休眠、唤醒
+            bool found = false;
+            for (int i = 0; i < kSpinCount_ && !found; ++i) {
+                std::this_thread::yield();
+                found = TryGetTask(idx, task);
+            }
+            if (found) {
+                RunTask(task);
+                continue;
+            }
+            if (is_shutdown_) {
+                break;
+            }
+            Park(idx, task);
+            if (task) {
+                RunTask(task);
+            }
+        }
+    }
+
+    void WaitStarted() {
+        std::unique_lock<std::mutex> lck(start_mtx_);
+        start_cv_.wait(lck, [this]() { return started_cnt_ == workers_.size(); });
+    }
+
+    static void RunTask(Task& task) {
+        Metrics::Observe(Histogram::TASK_WAIT,
+                         Metrics::Now() - task.enqueued_at());
+        task();
+        task.Reset();
+    }
+
+    // 依次尝试：自己的队列 -> 窃取其他线程的队列 -> 溢出队列
+    bool TryGetTask(size_t idx, Task& task) {
+        const size_t n = workers_.size();
+        for (size_t i = 0; i < n; ++i) {
+            if (workers_[(idx + i) % n]->queue.Pop(task)) {
+                return true;
+            }
+        }
+        if (overflow_size_.load(std::memory_order_relaxed) > 0) {
+            std::lock_guard<std::mutex> lck(overflow_mtx_);
+            if (!overflow_.empty()) {
+                task = std::move(overflow_.front());
+                overflow_.pop_front();
+                --overflow_size_;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // 休眠，直到被 AddTask 或析构函数唤醒
+    // 休眠前再检查一次任务队列，检查时取到的任务通过 task 带回
+    void Park(size_t idx, Task& task) {
+        Worker& self = *workers_[idx];
+        self.is_sleeping.store(true);
+        ++idle_cnt_;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (TryGetTask(idx, task) || is_shutdown_) {
+            if (self.is_sleeping.exchange(false)) {
+                --idle_cnt_;
+            }
+            return;
+        }
+        std::unique_lock<std::mutex> lck(self.mtx);
+        while (!self.is_notified) {
+            self.cv.wait(lck);
+        }
+        self.is_notified = false;
+    }
+
+    // 只唤醒一个休眠的线程，优先唤醒任务所在队列的线程，避免惊群
+    void WakeOne(size_t target) {
+        const size_t n = workers_.size();
+        for (size_t i = 0; i < n; ++i) {
+            Worker& worker = *workers_[(target + i) % n];
+            if (worker.is_sleeping.load(std::memory_order_relaxed) &&
+                worker.is_sleeping.exchange(false)) {
+                --idle_cnt_;
+                Notify(worker);
+                return;
+            }
+        }
+    }
+
+    static void Notify(Worker& worker) {
+        std::unique_lock<std::mutex> lck(worker.mtx);
+        worker.is_notified = true;
+        lck.unlock();
+        worker.cv.notify_one();
+    }
+
+    std::vector<std::unique_ptr<Worker>> workers_;
     std::vector<std::thread> threads_;
-    std::queue<std::function<void()>> tasks_;
-    std::mutex mtx_;
-    std::condition_variable cv_;
-    bool is_shutdown_;
+    std::mutex start_mtx_;
+    std::condition_variable start_cv_;
+    size_t started_cnt_ = 0;  // 已分配好 Worker 的线程数
+    std::atomic<bool> is_shutdown_{false};
+    std::atomic<int> idle_cnt_{0};
+    std::atomic<size_t> next_{0};
+
+    std::mutex overflow_mtx_;
+    std::deque<Task> overflow_;
+    std::atomic<size_t> overflow_size_{0};
+
+    static inline thread_local const ThreadPool* current_pool_ = nullptr;
+    static inline thread_local size_t current_index_ = 0;
 };
 
-#endif
\ No newline at end of file
+#endif
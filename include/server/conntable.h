@@ -0,0 +1,30 @@
+// Author: Cukoo
+// Date: 2026-10-18
+
+#ifndef CONN_TABLE_H
+#define CONN_TABLE_H
+
+#include <assert.h>
+#include <memory>
+#include <vector>
+
+#include "http/httpconn.h"
+
+// 以 fd 为下标的连接表，所有 Reactor 共享
+// - 槽位数组按最大 fd 数一次性分配，不会扩容，HttpConn 的地址在整个生命周期内保持不变
+// - HttpConn 在 fd 第一次被使用时才创建，之后随 fd 的复用而复用
+// - 同一时刻一个 fd 只属于一个 Reactor，因此不同线程不会访问同一个槽位
+class ConnTable {
+   public:
+    explicit ConnTable(int max_fd);
+    ~ConnTable() = default;
+
+    HttpConn* Get(int fd);
+    HttpConn* Find(uint64_t tag) const;
+    int max_fd() const;
+
+   private:
+    std::vector<std::unique_ptr<HttpConn>> conns_;
+};
+
+#endif
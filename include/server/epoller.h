@@ -12,16 +12,21 @@
 #include <vector>
 #include <errno.h>
 
+// 注册时可以附带 64 位的事件数据（即 epoll_event.data），约定其低 32 位为 fd，
+// 高 32 位由调用者自行使用（如连接的 generation）
 class Epoller {
    public:
     explicit Epoller(int max_event_num = 1024);
     ~Epoller();
-    
+
     bool Add(int fd, uint32_t events);
+    bool Add(int fd, uint32_t events, uint64_t data);
     bool Modify(int fd, uint32_t events);
+    bool Modify(int fd, uint32_t events, uint64_t data);
     bool Remove(int fd);
     int Wait(int timeout = -1);
     int GetEventFd(size_t i) const;
+    uint64_t GetEventData(size_t i) const;
     uint32_t GetEvents(size_t i) const;
 
    private:
@@ -29,4 +34,4 @@ class Epoller {
     std::vector<epoll_event> events_;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,112 @@
+// Author: Cukoo
+// Date: 2026-10-17
+
+#ifndef REACTOR_H
+#define REACTOR_H
+
+#include <arpa/inet.h>
+#include <assert.h>
+#include <errno.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+#include "conntable.h"
+#include "epoller.h"
+#include "config/config.h"
+#include "http/httpconn.h"
+#include "http/userverify.h"
+#include "pool/cpuaffinity.h"
+#include "pool/sqlconnpool.h"
+#include "pool/threadpool.h"
+#include "timer/timerwheel.h"
+
+// 一个 Reactor 即一个事件循环，拥有自己的 Epoller、定时器容器，负责一部分连接
+// - 单 Reactor 模式：与线程池配合，读写任务交给工作线程执行（EPOLLONESHOT）
+// - 多 Reactor 模式：thread_pool 为空，读、处理、写都直接在 Reactor 线程中完成
+class Reactor {
+   public:
+    Reactor(const Config& config,
+            ConnTable* conns,
+            ThreadPool* thread_pool = nullptr,
+            int max_event_num = 1024);
+    ~Reactor();
+
+    void Loop();
+    void Quit();
+
+    void SetAcceptor(int listenfd, uint32_t events,
+                     const std::function<void()>& on_accept);
+    void AddConn(int fd, const sockaddr_in& addr);
+    void QueueInLoop(std::function<void()> cb);
+    // 在 Loop 之前调用：Reactor 线程开始循环时绑定到 cpu 上
+    void BindCpu(int cpu);
+
+    int conn_count() const;
+    int cpu() const;
+
+   private:
+    bool IsInLoopThread() const;
+    void Wakeup();
+    void HandleWakeup();
+    void RegisterConn(int fd, const sockaddr_in& addr);
+
+    void HandleReadableEvent(HttpConn* client);
+    void HandleWritableEvent(HttpConn* client);
+
+    void ArmTimer(HttpConn* client);
+    int64_t Deadline(HttpConn* client) const;
+    static void OnTimeout(void* ctx, TimerNode* node);
+    void CloseConn(HttpConn* client);
+
+    void OnRead(HttpConn* client);
+    void OnWrite(HttpConn* client);
+    void OnProcess(HttpConn* client);
+
+    void StartVerify(HttpConn* client);
+    void ContinueVerify(UserVerifyTask* task, uint32_t events);
+    void FinishVerify(UserVerifyTask* task);
+
+    const int kTimeout_;        // 空闲超时，不大于 0 时不设任何超时
+    const int kHeaderTimeout_;  // 以下不大于 0 时使用 kTimeout_
+    const int kBodyTimeout_;
+    const int kWriteTimeout_;
+    const int kMinTimeout_;  // 以上各个超时中最短的一个
+    static constexpr int kBusyRecheck_ = 5;  // 单位：ms，超时的连接正被工作线程处理时，隔多久再检查
+    std::atomic<bool> is_closed_;
+    std::atomic<int> conn_count_;
+    std::atomic<std::thread::id> thread_id_;  // 由 Reactor 线程写入，其他线程在 AddConn 等中读取
+    int cpu_;  // 绑定的 CPU，-1 表示不绑定
+
+    int listenfd_;
+    int wakeup_fd_;
+    uint32_t connfd_event_;
+    std::function<void()> on_accept_;
+
+    ThreadPool* thread_pool_;  // 为空时为多 Reactor 模式
+    std::unique_ptr<TimerWheel> timer_wheel_;
+    std::unique_ptr<Epoller> epoller_;
+    ConnTable* conns_;  // 所有 Reactor 共享，由 WebServer 持有
+
+    std::mutex mtx_;  // 保护 pending_conns_、pending_tasks_
+    std::vector<std::pair<int, sockaddr_in>> pending_conns_;
+    std::vector<std::function<void()>> pending_tasks_;  // 其他线程交给 Reactor 线程执行的任务
+
+    // 用完读预算、需要继续读的连接（多 Reactor 模式），只在 Reactor 线程中访问
+    std::vector<uint64_t> resume_reads_;
+
+    // 正在等待的 MySQL socket -> 验证任务（非阻塞 API），只在 Reactor 线程中访问
+    std::unordered_map<int, UserVerifyTask*> verify_tasks_;
+};
+
+#endif
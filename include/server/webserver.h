@@ -4,24 +4,27 @@
 #ifndef WEB_SERVER_H
 #define WEB_SERVER_H
 
-#include <unordered_map>
-#include <fcntl.h>       
-#include <unistd.h>      
+#include <fcntl.h>
+#include <unistd.h>
 #include <assert.h>
 #include <errno.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
+#include <thread>
+#include <vector>
 
 #include <spdlog/spdlog.h>
 
 #include "epoller.h"
-#include "timer/timerheap.h"
+#include "conntable.h"
+#include "reactor.h"
 #include "pool/sqlconnpool.h"
 #include "pool/threadpool.h"
-#include "pool/sqlconnguard.h"
 #include "http/httpconn.h"
 #include "config/config.h"
+#include "metrics/metrics.h"
+#include "log/accesslog.h"
 
 class WebServer {
     public:
@@ -31,37 +34,35 @@ class WebServer {
     void Startup();
 
     private:
-    static const int kMaxFd_ = 65536;
     static int SetFdNonblock(int fd);
 
     bool InitListenSocket();
+    void RegisterMetrics();
 
     void HandleListenFdEvent();
-    void HandleReadableEvent(HttpConn* client);
-    void HandleWritableEvent(HttpConn* client);
+    void BuildSteeringMap();
+    Reactor* NextReactor(int fd);
 
     void SendError(int fd, const char* info);
-    void ResetTimer(HttpConn* client);
-    void CloseConn(HttpConn* client);
-
-    void OnRead(HttpConn* client);
-    void OnWrite(HttpConn* client);
-    void OnProcess(HttpConn* client);
 
     const int kPort_;
     const int kTimeout_;
     const bool kEnableLinger_;
     const std::string kWorkDir_;
+    const DispatchPolicy kDispatchPolicy_;
+    const int kMaxFd_;
     bool is_closed_;
     int listenfd_;
 
     uint32_t listenfd_event_;
-    uint32_t connfd_event_;
 
-    std::unique_ptr<TimerHeap> timer_heap_;
-    std::unique_ptr<ThreadPool> thread_pool_;
-    std::unique_ptr<Epoller> epoller_;
-    std::unordered_map<int, HttpConn> clients_;
+    size_t next_reactor_;
+    std::vector<int> cpu_to_reactor_;  // INCOMING_CPU 策略：CPU -> 负责的 Reactor 的下标
+    std::unique_ptr<ConnTable> conns_;  // 后于 reactors_ 析构
+    std::unique_ptr<Epoller> epoller_;  // 多 Reactor 模式下主线程只监听 listenfd_
+    std::vector<std::unique_ptr<Reactor>> reactors_;
+    std::vector<std::thread> reactor_threads_;
+    std::unique_ptr<ThreadPool> thread_pool_;  // 先于 reactors_ 析构
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,60 @@
+// Author: Cukoo
+// Date: 2026-10-18
+
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <assert.h>
+#include <chrono>
+#include <cstdint>
+
+// 侵入式定时器结点，嵌入在被定时的对象（如 HttpConn）中，不需要额外分配内存
+struct TimerNode {
+    TimerNode* prev = nullptr;
+    TimerNode* next = nullptr;
+    int64_t expires = 0;    // 最新的超时时刻（单位：ms）
+    int64_t scheduled = 0;  // 所在槽位按哪个超时时刻放入
+    void* data = nullptr;   // 由使用者设置，超时回调中用来找到被定时的对象
+
+    bool IsLinked() const { return prev != nullptr; }
+};
+
+// 分层时间轮，精度为 1ms，共 4 层，每层 64 个槽位（可表示约 4.6 小时）
+// - 添加、删除、延后都是 O(1)
+// - 延后是惰性的：只记录新的超时时刻，结点所在的槽位到期时再重新放入合适的槽位
+// - 所有结点共用一个超时回调（函数指针 + 上下文），不使用 std::function
+class TimerWheel {
+   public:
+    using TimeoutHandler = void (*)(void* ctx, TimerNode* node);
+
+    TimerWheel(TimeoutHandler handler, void* ctx);
+    ~TimerWheel();
+
+    void Schedule(TimerNode* node, int timeout);
+    void Cancel(TimerNode* node);
+    int Tick();
+    size_t size() const;
+
+    // 单调时钟的当前时刻（单位：ms），与 TimerNode::expires 使用同一个时钟
+    static int64_t Now();
+
+   private:
+    static constexpr int kLevels_ = 4;
+    static constexpr int kSlotBits_ = 6;
+    static constexpr int kSlots_ = 1 << kSlotBits_;
+
+    void Link(TimerNode* node);
+    void Unlink(TimerNode* node);
+    void Cascade(int level);
+    void Expire(TimerNode* head);
+    int NextTimeout() const;
+
+    TimeoutHandler handler_;
+    void* ctx_;
+    int64_t current_;  // 已经处理到的时刻
+    size_t size_;
+    TimerNode slots_[kLevels_][kSlots_];  // 每个槽位是一个带头结点的双向循环链表
+    uint64_t occupied_[kLevels_];         // 非空槽位的位图
+};
+
+#endif
@@ -3,58 +3,90 @@
 
 #include "buffer/buffer.h"
 
-Buffer::Buffer(int init_buff_size)
-    : buffer_(init_buff_size), read_pos_(0), write_pos_(0) {}
+#include <algorithm>
 
-size_t Buffer::ReadableBytes() const {
-    return write_pos_ - read_pos_;
-}
+Buffer::Buffer() : head_(nullptr), tail_(nullptr), readable_(0) {}
 
-size_t Buffer::WritableBytes() const {
-    return buffer_.size() - write_pos_;
+Buffer::~Buffer() {
+    RetrieveAll();
 }
 
-size_t Buffer::PrependableBytes() const {
-    return read_pos_;
+size_t Buffer::ReadableBytes() const {
+    return readable_;
 }
 
 const char* Buffer::ReadBegin() const {
-    return Begin() + read_pos_;
+    return head_ ? head_->data() + head_->read : "";
+}
+
+// 请求报文跨越多个块时，解析前先合并到一个块中
+// 新块留出与已有数据等长的空间，之后到达的数据直接读到后面，不必每次都重新合并
+const char* Buffer::Linearize() {
+    if (head_ == tail_) {
+        return ReadBegin();
+    }
+    Chunk* merged = ChunkPool::Get(2 * readable_);
+    for (Chunk* chunk = head_; chunk;) {
+        memcpy(merged->data() + merged->write, chunk->data() + chunk->read,
+               chunk->Readable());
+        merged->write += chunk->Readable();
+        Chunk* next = chunk->next;
+        ChunkPool::Put(chunk);
+        chunk = next;
+    }
+    head_ = tail_ = merged;
+    return ReadBegin();
 }
 
 void Buffer::Retrieve(size_t len) {
     assert(len <= ReadableBytes());
-    read_pos_ += len;
+    readable_ -= len;
+    // 数据全部取走时归还所有的块
+    if (readable_ == 0) {
+        RetrieveAll();
+        return;
+    }
+    while (len > 0) {
+        size_t n = std::min(len, head_->Readable());
+        head_->read += n;
+        len -= n;
+        if (head_->Readable() == 0) {
+            Chunk* next = head_->next;
+            ChunkPool::Put(head_);
+            head_ = next;
+        }
+    }
 }
 
+// end 须位于第一个块中
 void Buffer::RetrieveUntil(const char* end) {
-    assert(ReadBegin() <= end);
+    assert(ReadBegin() <= end && end <= ReadBegin() + head_->Readable());
     Retrieve(end - ReadBegin());
 }
 
 void Buffer::RetrieveAll() {
-    memset(&buffer_[0], 0, buffer_.size());
-    read_pos_ = 0;
-    write_pos_ = 0;
-}
-
-const char* Buffer::ConstWriteBegin() const {
-    return Begin() + write_pos_;
-}
-
-char* Buffer::WriteBegin() {
-    return Begin() + write_pos_;
-}
-
-void Buffer::HasWritten(size_t len) {
-    write_pos_ += len;
+    while (head_) {
+        Chunk* next = head_->next;
+        ChunkPool::Put(head_);
+        head_ = next;
+    }
+    tail_ = nullptr;
+    readable_ = 0;
 }
 
 void Buffer::Append(const char* str, size_t len) {
-    assert(str);
-    EnsureWritable(len);
-    std::copy(str, str + len, WriteBegin());
-    HasWritten(len);
+    assert(str || len == 0);
+    readable_ += len;
+    while (len > 0) {
+        if (!tail_ || tail_->Writable() == 0) {
+            PushChunk(ChunkPool::Get());
+        }
+        size_t n = std::min(len, tail_->Writable());
+        memcpy(tail_->data() + tail_->write, str, n);
+        tail_->write += n;
+        str += n;
+        len -= n;
+    }
 }
 
 void Buffer::Append(const std::string& str) {
@@ -62,69 +94,71 @@ void Buffer::Append(const std::string& str) {
 }
 
 void Buffer::Append(const Buffer& buff) {
-    Append(buff.ReadBegin(), buff.ReadableBytes());
-}
-
-void Buffer::EnsureWritable(size_t len) {
-    if (WritableBytes() < len) {
-        MakeSpace(len);
-    }
-    assert(WritableBytes() >= len);
+    buff.ForEachChunk([this](const char* data, size_t len) { Append(data, len); });
 }
 
 // 从 fd 中读取数据，写入到 Buffer 中
+// 分散读：先填满最后一个块的剩余空间，再填入若干新块，没用上的新块立即归还
 ssize_t Buffer::ReadFd(int fd, int* save_errno) {
-    // 为了保证有足够的空间存储从 fd 中读取到的数据
-    // 设置一个辅助数组，分散读，最后再合并起来
-    char buff[2048];  // 辅助数组大小应该根据实际需求调整
-    iovec iov[2]{};
-    const size_t writable_bytes = WritableBytes();
-    iov[0].iov_base = Begin() + write_pos_;
-    iov[0].iov_len = writable_bytes;
-    iov[1].iov_base = buff;
-    iov[1].iov_len = sizeof(buff);
-
-    const ssize_t len = readv(fd, iov, 2);
+    iovec iov[kReadChunks_ + 1];
+    Chunk* fresh[kReadChunks_];
+    int cnt = 0;
+    const size_t tail_writable = tail_ ? tail_->Writable() : 0;
+    if (tail_writable > 0) {
+        iov[cnt++] = {tail_->data() + tail_->write, tail_writable};
+    }
+    for (int i = 0; i < kReadChunks_; ++i) {
+        fresh[i] = ChunkPool::Get();
+        iov[cnt++] = {fresh[i]->data(), fresh[i]->cap};
+    }
+
+    const ssize_t len = readv(fd, iov, cnt);
     if (len < 0) {
         *save_errno = errno;
-    } else if (len <= writable_bytes) {
-        HasWritten(len);
-    } else {
-        write_pos_ = buffer_.size();
-        Append(buff, len - writable_bytes);
+    }
+    size_t left = len > 0 ? len : 0;
+    readable_ += left;
+    size_t n = std::min(left, tail_writable);
+    if (n > 0) {
+        tail_->write += n;
+        left -= n;
+    }
+    for (int i = 0; i < kReadChunks_; ++i) {
+        if (left == 0) {
+            ChunkPool::Put(fresh[i]);
+            continue;
+        }
+        fresh[i]->write = std::min(left, fresh[i]->cap);
+        left -= fresh[i]->write;
+        PushChunk(fresh[i]);
     }
     return len;
 }
 
-// 从 Buffer 中读取数据，写入到 fd 中
+// 从 Buffer 中读取数据，写入到 fd 中（聚集写）
 ssize_t Buffer::WriteFd(int fd, int* save_errno) {
-    ssize_t len = write(fd, ReadBegin(), ReadableBytes());
+    iovec iov[kMaxIov_];
+    int cnt = 0;
+    for (Chunk* chunk = head_; chunk && cnt < kMaxIov_; chunk = chunk->next) {
+        if (chunk->Readable() > 0) {
+            iov[cnt++] = {chunk->data() + chunk->read, chunk->Readable()};
+        }
+    }
+    const ssize_t len = writev(fd, iov, cnt);
     if (len < 0) {
         *save_errno = errno;
     } else {
-        read_pos_ += len;
+        Retrieve(len);
     }
     return len;
 }
 
-char* Buffer::Begin() {
-    return &buffer_[0];
-}
-
-const char* Buffer::Begin() const {
-    return &buffer_[0];
-}
-
-// 确保待写入区间长度不小于 len 个字节
-void Buffer::MakeSpace(size_t len) {
-    // 如果可以复用 [0, read_pos_)，就紧凑一下，否则进行扩容。
-    if (WritableBytes() + PrependableBytes() >= len) {
-        size_t readable_bytes = ReadableBytes();
-        std::copy(Begin() + read_pos_, Begin() + write_pos_, Begin());
-        read_pos_ = 0;
-        write_pos_ = read_pos_ + readable_bytes;
-        assert(readable_bytes == ReadableBytes());
+void Buffer::PushChunk(Chunk* chunk) {
+    chunk->next = nullptr;
+    if (tail_) {
+        tail_->next = chunk;
     } else {
-        buffer_.resize(write_pos_ + len + 1);
+        head_ = chunk;
     }
+    tail_ = chunk;
 }
@@ -0,0 +1,80 @@
+// Author: Cukoo
+// Date: 2026-10-18
+
+#include "buffer/chunkpool.h"
+
+#include <new>
+
+std::atomic<size_t> ChunkPool::heap_bytes_{0};
+
+namespace {
+
+// 线程的空闲块缓存，线程退出时释放
+struct ThreadCache {
+    Chunk* head = nullptr;
+    size_t size = 0;
+    ~ThreadCache();
+};
+
+thread_local ThreadCache cache;
+// 线程退出、cache 析构之后仍可能有块被归还（如其他 thread_local 对象中的 Buffer）
+thread_local bool cache_destroyed = false;
+
+}  // namespace
+
+ThreadCache::~ThreadCache() {
+    cache_destroyed = true;
+    while (head) {
+        Chunk* chunk = head;
+        head = head->next;
+        ChunkPool::Put(chunk);
+    }
+}
+
+Chunk* ChunkPool::Get(size_t min_cap) {
+    if (min_cap > kCapacity_) {
+        // 按定长块的整数倍申请
+        size_t size = (sizeof(Chunk) + min_cap + kChunkSize_ - 1) / kChunkSize_ *
+                      kChunkSize_;
+        return Allocate(size - sizeof(Chunk));
+    }
+    Chunk* chunk;
+    if (!cache_destroyed && cache.head) {
+        chunk = cache.head;
+        cache.head = chunk->next;
+        --cache.size;
+    } else {
+        chunk = Allocate(kCapacity_);
+    }
+    chunk->next = nullptr;
+    chunk->read = chunk->write = 0;
+    return chunk;
+}
+
+void ChunkPool::Put(Chunk* chunk) {
+    if (chunk->cap != kCapacity_ || cache_destroyed || cache.size >= kMaxCached_) {
+        Free(chunk);
+        return;
+    }
+    chunk->next = cache.head;
+    cache.head = chunk;
+    ++cache.size;
+}
+
+size_t ChunkPool::HeapBytes() {
+    return heap_bytes_.load(std::memory_order_relaxed);
+}
+
+Chunk* ChunkPool::Allocate(size_t cap) {
+    Chunk* chunk = static_cast<Chunk*>(::operator new(sizeof(Chunk) + cap));
+    chunk->next = nullptr;
+    chunk->cap = cap;
+    chunk->read = chunk->write = 0;
+    heap_bytes_.fetch_add(sizeof(Chunk) + cap, std::memory_order_relaxed);
+    return chunk;
+}
+
+void ChunkPool::Free(Chunk* chunk) {
+    heap_bytes_.fetch_sub(sizeof(Chunk) + chunk->cap, std::memory_order_relaxed);
+    ::operator delete(chunk);
+}
@@ -0,0 +1,138 @@
+// Author: Cukoo
+// Date: 2026-10-18
+
+#include "http/bodystore.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <cstring>
+#include <spdlog/spdlog.h>
+
+size_t BodyStore::kSpillThreshold_ = 64 * 1024;
+std::string BodyStore::kSpillDir_ = "/tmp";
+
+BodyStore::BodyStore() : fd_(-1), pipe_{-1, -1}, size_(0) {}
+
+BodyStore::~BodyStore() {
+    Reset();
+}
+
+void BodyStore::Clear() {
+    if (fd_ >= 0) {
+        close(fd_);
+        fd_ = -1;
+    }
+    mem_.clear();
+    if (mem_.capacity() > kKeepCapacity_) {
+        std::string().swap(mem_);
+    }
+    size_ = 0;
+}
+
+void BodyStore::Reset() {
+    Clear();
+    std::string().swap(mem_);
+    if (pipe_[0] >= 0) {
+        close(pipe_[0]);
+        close(pipe_[1]);
+        pipe_[0] = pipe_[1] = -1;
+    }
+}
+
+bool BodyStore::Append(const char* data, size_t len) {
+    if (fd_ < 0 && size_ + len > kSpillThreshold_ && !Spill()) {
+        return false;
+    }
+    size_ += len;
+    if (fd_ < 0) {
+        mem_.append(data, len);
+        return true;
+    }
+    return WriteAll(data, len);
+}
+
+// 管道中的数据一次全部移入文件：文件系统不支持 splice 时退回 read + write，
+// 失败时这些数据已从 socket 中取出，只能返回错误
+ssize_t BodyStore::Splice(int fd, size_t len, int* save_errno) {
+    assert(fd_ >= 0);
+    if (pipe_[0] < 0 && pipe2(pipe_, O_NONBLOCK | O_CLOEXEC) < 0) {
+        *save_errno = errno;
+        return -1;
+    }
+    ssize_t n = splice(fd, nullptr, pipe_[1], nullptr, len,
+                       SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+    if (n <= 0) {
+        *save_errno = errno;
+        return n;
+    }
+    size_t left = n;
+    while (left > 0) {
+        ssize_t m = splice(pipe_[0], nullptr, fd_, nullptr, left, SPLICE_F_MOVE);
+        if (m <= 0) {
+            char buf[4096];
+            m = read(pipe_[0], buf, std::min(left, sizeof(buf)));
+            if (m <= 0 || !WriteAll(buf, m)) {
+                *save_errno = EIO;
+                return -1;
+            }
+        }
+        left -= m;
+    }
+    size_ += n;
+    return n;
+}
+
+bool BodyStore::IsSpilled() const {
+    return fd_ >= 0;
+}
+
+std::string_view BodyStore::data() const {
+    return mem_;
+}
+
+int BodyStore::fd() const {
+    return fd_;
+}
+
+size_t BodyStore::size() const {
+    return size_;
+}
+
+// 创建匿名的临时文件（O_TMPFILE，不支持时 mkstemp 后立即 unlink），并写入内存中已有的内容
+bool BodyStore::Spill() {
+    fd_ = open(kSpillDir_.c_str(), O_TMPFILE | O_RDWR | O_CLOEXEC, 0600);
+    if (fd_ < 0) {
+        std::string path = kSpillDir_ + "/body-XXXXXX";
+        fd_ = mkostemp(path.data(), O_CLOEXEC);
+        if (fd_ >= 0) {
+            unlink(path.c_str());
+        }
+    }
+    if (fd_ < 0) {
+        spdlog::error("Failed to create a temporary file in {}: {}", kSpillDir_,
+                      strerror(errno));
+        return false;
+    }
+    bool ok = WriteAll(mem_.data(), mem_.size());
+    std::string().swap(mem_);
+    return ok;
+}
+
+bool BodyStore::WriteAll(const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd_, data, len);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            spdlog::error("Failed to write a request body to disk: {}",
+                          strerror(errno));
+            return false;
+        }
+        data += n;
+        len -= n;
+    }
+    return true;
+}
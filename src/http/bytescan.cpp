@@ -0,0 +1,319 @@
+// Author: Cukoo
+// Date: 2026-10-18
+
+#include "http/bytescan.h"
+
+#include <assert.h>
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BYTE_SCAN_X86
+#endif
+
+namespace {
+
+using FindFirstOfFn = const char* (*)(const char*, const char*, const char*);
+using FindNonTokenFn = const char* (*)(const char*, const char*);
+
+// tchar = "!" / "#" / "$" / "%" / "&" / "'" / "*" / "+" / "-" / "." /
+//         "^" / "_" / "`" / "|" / "~" / DIGIT / ALPHA
+constexpr bool IsToken(unsigned char ch) {
+    return (ch >= '0' && ch <= '9') || (ch >= 'A' && ch <= 'Z') ||
+           (ch >= 'a' && ch <= 'z') ||
+           std::string_view("!#$%&'*+-.^_`|~").find(ch) != std::string_view::npos;
+}
+
+constexpr std::array<bool, 256> MakeTokenTable() {
+    std::array<bool, 256> table{};
+    for (int ch = 0; ch < 256; ++ch) {
+        table[ch] = IsToken(ch);
+    }
+    return table;
+}
+
+constexpr std::array<bool, 256> kTokenTable = MakeTokenTable();
+
+// 按低 4 位索引的位图：字节 (hi << 4 | lo) 是 token 字符时，kTokenLo[lo] 的第 hi 位为 1
+// token 字符都小于 0x80，hi 只需要 0 ~ 7
+constexpr std::array<uint8_t, 16> MakeTokenLo() {
+    std::array<uint8_t, 16> lut{};
+    for (int ch = 0; ch < 128; ++ch) {
+        if (kTokenTable[ch]) {
+            lut[ch & 0x0F] |= 1 << (ch >> 4);
+        }
+    }
+    return lut;
+}
+
+alignas(32) constexpr std::array<uint8_t, 16> kTokenLo = MakeTokenLo();
+// 按高 4 位索引：hi 对应的位，hi >= 8 时为 0（一定不是 token 字符）
+alignas(32) constexpr uint8_t kTokenHi[16] = {1, 2, 4, 8, 16, 32, 64, 128,
+                                             0, 0, 0, 0, 0, 0, 0, 0};
+
+const char* FindFirstOfScalar(const char* p, const char* end, const char* set) {
+    for (; p < end; ++p) {
+        if (*p == set[0] || *p == set[1] || *p == set[2] || *p == set[3]) {
+            return p;
+        }
+    }
+    return end;
+}
+
+const char* FindNonTokenScalar(const char* p, const char* end) {
+    while (p < end && kTokenTable[static_cast<unsigned char>(*p)]) {
+        ++p;
+    }
+    return p;
+}
+
+#ifdef BYTE_SCAN_X86
+
+// SSE2 是 x86-64 的基线指令集，不需要 target 属性
+const char* FindFirstOfSse2(const char* p, const char* end, const char* set) {
+    const __m128i c0 = _mm_set1_epi8(set[0]);
+    const __m128i c1 = _mm_set1_epi8(set[1]);
+    const __m128i c2 = _mm_set1_epi8(set[2]);
+    const __m128i c3 = _mm_set1_epi8(set[3]);
+    for (; end - p >= 16; p += 16) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i eq = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(x, c0), _mm_cmpeq_epi8(x, c1)),
+            _mm_or_si128(_mm_cmpeq_epi8(x, c2), _mm_cmpeq_epi8(x, c3)));
+        int mask = _mm_movemask_epi8(eq);
+        if (mask) {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    return FindFirstOfScalar(p, end, set);
+}
+
+__attribute__((target("ssse3")))
+const char* FindNonTokenSsse3(const char* p, const char* end) {
+    const __m128i lo_lut =
+        _mm_load_si128(reinterpret_cast<const __m128i*>(kTokenLo.data()));
+    const __m128i hi_lut = _mm_load_si128(reinterpret_cast<const __m128i*>(kTokenHi));
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    const __m128i zero = _mm_setzero_si128();
+    for (; end - p >= 16; p += 16) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i row = _mm_shuffle_epi8(lo_lut, _mm_and_si128(x, nibble));
+        __m128i bit = _mm_shuffle_epi8(
+            hi_lut, _mm_and_si128(_mm_srli_epi16(x, 4), nibble));
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(row, bit), zero));
+        if (mask) {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    return FindNonTokenScalar(p, end);
+}
+
+// AVX2 的实现不调用 SSE2 的实现处理尾部：ymm 寄存器的高位未清零时执行非 VEX 编码的
+// SSE 指令会有状态切换的开销，请求行、请求头大多不足 32 字节，每次调用都会付出这一开销
+// 尾部在同一函数内以 16 字节（VEX 编码）和逐字节处理
+__attribute__((target("avx2")))
+const char* FindFirstOfAvx2(const char* p, const char* end, const char* set) {
+    if (end - p >= 32) {
+        const __m256i c0 = _mm256_set1_epi8(set[0]);
+        const __m256i c1 = _mm256_set1_epi8(set[1]);
+        const __m256i c2 = _mm256_set1_epi8(set[2]);
+        const __m256i c3 = _mm256_set1_epi8(set[3]);
+        for (; end - p >= 32; p += 32) {
+            __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+            __m256i eq = _mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi8(x, c0), _mm256_cmpeq_epi8(x, c1)),
+                _mm256_or_si256(_mm256_cmpeq_epi8(x, c2), _mm256_cmpeq_epi8(x, c3)));
+            uint32_t mask = _mm256_movemask_epi8(eq);
+            if (mask) {
+                _mm256_zeroupper();
+                return p + __builtin_ctz(mask);
+            }
+        }
+        _mm256_zeroupper();
+    }
+    if (end - p >= 16) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i eq = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8(set[0])),
+                         _mm_cmpeq_epi8(x, _mm_set1_epi8(set[1]))),
+            _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8(set[2])),
+                         _mm_cmpeq_epi8(x, _mm_set1_epi8(set[3]))));
+        int mask = _mm_movemask_epi8(eq);
+        if (mask) {
+            return p + __builtin_ctz(mask);
+        }
+        p += 16;
+    }
+    for (; p < end; ++p) {
+        if (*p == set[0] || *p == set[1] || *p == set[2] || *p == set[3]) {
+            return p;
+        }
+    }
+    return end;
+}
+
+__attribute__((target("avx2")))
+const char* FindNonTokenAvx2(const char* p, const char* end) {
+    const __m128i lo_lut =
+        _mm_load_si128(reinterpret_cast<const __m128i*>(kTokenLo.data()));
+    const __m128i hi_lut = _mm_load_si128(reinterpret_cast<const __m128i*>(kTokenHi));
+    if (end - p >= 32) {
+        const __m256i lo_lut2 = _mm256_broadcastsi128_si256(lo_lut);
+        const __m256i hi_lut2 = _mm256_broadcastsi128_si256(hi_lut);
+        const __m256i nibble = _mm256_set1_epi8(0x0F);
+        const __m256i zero = _mm256_setzero_si256();
+        for (; end - p >= 32; p += 32) {
+            __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+            __m256i row = _mm256_shuffle_epi8(lo_lut2, _mm256_and_si256(x, nibble));
+            __m256i bit = _mm256_shuffle_epi8(
+                hi_lut2, _mm256_and_si256(_mm256_srli_epi16(x, 4), nibble));
+            uint32_t mask = _mm256_movemask_epi8(
+                _mm256_cmpeq_epi8(_mm256_and_si256(row, bit), zero));
+            if (mask) {
+                _mm256_zeroupper();
+                return p + __builtin_ctz(mask);
+            }
+        }
+        _mm256_zeroupper();
+    }
+    if (end - p >= 16) {
+        const __m128i nibble = _mm_set1_epi8(0x0F);
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i row = _mm_shuffle_epi8(lo_lut, _mm_and_si128(x, nibble));
+        __m128i bit = _mm_shuffle_epi8(
+            hi_lut, _mm_and_si128(_mm_srli_epi16(x, 4), nibble));
+        int mask = _mm_movemask_epi8(
+            _mm_cmpeq_epi8(_mm_and_si128(row, bit), _mm_setzero_si128()));
+        if (mask) {
+            return p + __builtin_ctz(mask);
+        }
+        p += 16;
+    }
+    while (p < end && kTokenTable[static_cast<unsigned char>(*p)]) {
+        ++p;
+    }
+    return p;
+}
+
+#endif  // BYTE_SCAN_X86
+
+struct Kernels {
+    ByteScan::Isa isa;
+    FindFirstOfFn find_first_of;
+    FindNonTokenFn find_non_token;
+};
+
+bool Supports(ByteScan::Isa isa) {
+#ifdef BYTE_SCAN_X86
+    if (isa == ByteScan::Isa::AVX2) {
+        return __builtin_cpu_supports("avx2");
+    }
+    return true;
+#else
+    return isa == ByteScan::Isa::SCALAR;
+#endif
+}
+
+Kernels MakeKernels(ByteScan::Isa isa) {
+#ifdef BYTE_SCAN_X86
+    if (isa == ByteScan::Isa::AVX2) {
+        return {isa, FindFirstOfAvx2, FindNonTokenAvx2};
+    }
+    if (isa == ByteScan::Isa::SSE2) {
+        return {isa, FindFirstOfSse2,
+                __builtin_cpu_supports("ssse3") ? FindNonTokenSsse3
+                                                : FindNonTokenScalar};
+    }
+#endif
+    return {ByteScan::Isa::SCALAR, FindFirstOfScalar, FindNonTokenScalar};
+}
+
+Kernels& Active() {
+    static Kernels kernels = MakeKernels(
+        Supports(ByteScan::Isa::AVX2)
+            ? ByteScan::Isa::AVX2
+            : (Supports(ByteScan::Isa::SSE2) ? ByteScan::Isa::SSE2
+                                             : ByteScan::Isa::SCALAR));
+    return kernels;
+}
+
+int HexValue(char ch) {
+    if (ch >= '0' && ch <= '9') {
+        return ch - '0';
+    }
+    if (ch >= 'A' && ch <= 'F') {
+        return ch - 'A' + 10;
+    }
+    if (ch >= 'a' && ch <= 'f') {
+        return ch - 'a' + 10;
+    }
+    return -1;
+}
+
+}  // namespace
+
+const char* ByteScan::FindFirstOf(const char* begin,
+                                  const char* end,
+                                  std::string_view set) {
+    assert(!set.empty() && set.size() <= 4);
+    // 单个字节交给 memchr：glibc 已按 CPU 选择了向量化的实现，且实测比这里的实现更快
+    if (set.size() == 1) {
+        const void* found = memchr(begin, set[0], end - begin);
+        return found ? static_cast<const char*>(found) : end;
+    }
+    // 不足 4 个字节时重复第一个字节
+    char chars[4] = {set[0], set[0], set[0], set[0]};
+    memcpy(chars, set.data(), set.size());
+    return Active().find_first_of(begin, end, chars);
+}
+
+const char* ByteScan::FindNonToken(const char* begin, const char* end) {
+    return Active().find_non_token(begin, end);
+}
+
+// 转义之间的普通字节由 FindFirstOf 成段地找出并整段复制
+void ByteScan::PercentDecode(std::string_view in,
+                             std::string* out,
+                             bool plus_as_space) {
+    out->resize(in.size());
+    char* dst = out->data();
+    const char* p = in.data();
+    const char* end = p + in.size();
+    const std::string_view specials = plus_as_space ? "%+" : "%";
+    while (p < end) {
+        const char* q = FindFirstOf(p, end, specials);
+        memcpy(dst, p, q - p);
+        dst += q - p;
+        p = q;
+        if (p == end) {
+            break;
+        }
+        if (*p == '+') {
+            *dst++ = ' ';
+            ++p;
+            continue;
+        }
+        int hi, lo;
+        if (end - p >= 3 && (hi = HexValue(p[1])) >= 0 && (lo = HexValue(p[2])) >= 0) {
+            *dst++ = static_cast<char>(hi << 4 | lo);
+            p += 3;
+        } else {
+            *dst++ = *p++;
+        }
+    }
+    out->resize(dst - out->data());
+}
+
+ByteScan::Isa ByteScan::isa() {
+    return Active().isa;
+}
+
+bool ByteScan::SetIsa(Isa isa) {
+    if (!Supports(isa)) {
+        return false;
+    }
+    Active() = MakeKernels(isa);
+    return true;
+}
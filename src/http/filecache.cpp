@@ -0,0 +1,445 @@
+// Author: Cukoo
+// Date: 2026-10-18
+
+#include "http/filecache.h"
+
+#include <stdio.h>
+#include <time.h>
+#include <filesystem>
+
+#ifdef WITH_ZLIB
+#include <zlib.h>
+#endif
+#ifdef WITH_BROTLI
+#include <brotli/encode.h>
+#endif
+
+namespace {
+
+#ifdef WITH_ZLIB
+// gzip 格式（windowBits 加 16）
+bool GzipCompress(const char* data, size_t len, bool best, std::string* out) {
+    z_stream stream = {};
+    // 请求线程上使用中等级别，启动时预先压缩使用最高级别
+    int level = best ? Z_BEST_COMPRESSION : 6;
+    if (deflateInit2(&stream, level, Z_DEFLATED, 15 + 16, 9,
+                     Z_DEFAULT_STRATEGY) != Z_OK) {
+        return false;
+    }
+    out->resize(deflateBound(&stream, len));
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    stream.avail_in = len;
+    stream.next_out = reinterpret_cast<Bytef*>(&(*out)[0]);
+    stream.avail_out = out->size();
+    int ret = deflate(&stream, Z_FINISH);
+    out->resize(stream.total_out);
+    deflateEnd(&stream);
+    return ret == Z_STREAM_END;
+}
+#endif
+
+#ifdef WITH_BROTLI
+// 最高质量（11）压缩几 MB 的文件需要数秒，请求线程上只用质量 5
+bool BrotliCompress(const char* data, size_t len, bool best, std::string* out) {
+    size_t out_len = BrotliEncoderMaxCompressedSize(len);
+    if (out_len == 0) {
+        return false;
+    }
+    out->resize(out_len);
+    int quality = best ? BROTLI_MAX_QUALITY : 5;
+    if (!BrotliEncoderCompress(quality, BROTLI_DEFAULT_WINDOW,
+                               BROTLI_MODE_TEXT, len,
+                               reinterpret_cast<const uint8_t*>(data), &out_len,
+                               reinterpret_cast<uint8_t*>(&(*out)[0]))) {
+        return false;
+    }
+    out->resize(out_len);
+    return true;
+}
+#endif
+
+const char* EncodingSuffix(ContentEncoding encoding) {
+    return encoding == ContentEncoding::BROTLI ? ".br" : ".gz";
+}
+
+// HTTP 日期（IMF-fixdate），形如 "Sun, 06 Nov 1994 08:49:37 GMT"
+std::string FormatHttpDate(time_t t) {
+    struct tm tm;
+    gmtime_r(&t, &tm);
+    char buf[32];
+    size_t len = strftime(buf, sizeof(buf), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+    return std::string(buf, len);
+}
+
+// 形如 "a1b2-3c4d-17f1e2d3c4b5a697"：inode、大小、修改时间（ns）的十六进制
+std::string MakeETag(const struct stat& st) {
+    char buf[64];
+    int len = snprintf(buf, sizeof(buf), "\"%llx-%llx-%llx\"",
+                       static_cast<unsigned long long>(st.st_ino),
+                       static_cast<unsigned long long>(st.st_size),
+                       static_cast<unsigned long long>(st.st_mtim.tv_sec) *
+                               1000000000ULL +
+                           st.st_mtim.tv_nsec);
+    return std::string(buf, len);
+}
+
+bool IsNotOlder(const struct stat& a, const struct stat& b) {
+    return a.st_mtim.tv_sec > b.st_mtim.tv_sec ||
+           (a.st_mtim.tv_sec == b.st_mtim.tv_sec &&
+            a.st_mtim.tv_nsec >= b.st_mtim.tv_nsec);
+}
+
+}  // namespace
+
+const std::unordered_map<std::string, std::string> FileCache::kSuffixTypes_ = {
+    {".html", "text/html"},
+    {".xml", "text/xml"},
+    {".xhtml", "application/xhtml+xml"},
+    {".txt", "text/plain"},
+    {".rtf", "application/rtf"},
+    {".pdf", "application/pdf"},
+    {".word", "application/nsword"},
+    {".png", "image/png"},
+    {".gif", "image/gif"},
+    {".jpg", "image/jpeg"},
+    {".jpeg", "image/jpeg"},
+    {".au", "audio/basic"},
+    {".mpeg", "video/mpeg"},
+    {".mpg", "video/mpeg"},
+    {".avi", "video/x-msvideo"},
+    {".gz", "application/x-gzip"},
+    {".tar", "application/x-tar"},
+    {".css", "text/css "},
+    {".js", "text/javascript "},
+};
+
+CachedFile::~CachedFile() {
+    if (addr && content.empty()) {
+        munmap(addr, st.st_size);
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+FileCache* FileCache::Instance() {
+    static FileCache file_cache;
+    return &file_cache;
+}
+
+void FileCache::Init(int capacity,
+                     int revalidate_ms,
+                     long sendfile_threshold,
+                     Compression compression) {
+    assert(capacity >= 0 && revalidate_ms >= 0);
+    shard_capacity_ = (capacity + kShardNum_ - 1) / kShardNum_;
+    revalidate_ns_ = static_cast<int64_t>(revalidate_ms) * 1000000;
+    sendfile_threshold_ = sendfile_threshold;
+    compression_ = compression;
+    // 不缓存时压缩的结果无处保存，每个请求都要重新压缩，因此只使用预先压缩好的文件
+    if (compression_ != Compression::PRECOMPRESSED && shard_capacity_ == 0) {
+        spdlog::warn("File cache is disabled, in-memory compression is turned off.");
+        compression_ = Compression::PRECOMPRESSED;
+    }
+    if (compression_ != Compression::PRECOMPRESSED && !compress_pool_) {
+        compress_pool_.reset(new ThreadPool(1));
+    }
+}
+
+std::shared_ptr<const CachedFile> FileCache::Get(const std::string& path) {
+    if (shard_capacity_ == 0) {
+        ++misses_;
+        return Load(path);
+    }
+    Shard& shard = GetShard(path);
+    int64_t now = Now();
+    std::shared_ptr<CachedFile> file = Find(shard, path);
+    if (file) {
+        // 在校验间隔内直接使用，否则重新 stat，文件没有变化时继续使用
+        if (now - file->checked_at.load(std::memory_order_relaxed) <
+            revalidate_ns_) {
+            ++hits_;
+            return file;
+        }
+        struct stat st;
+        bool exists = stat(path.c_str(), &st) == 0;
+        if (IsSame(*file, exists, st)) {
+            file->checked_at.store(now, std::memory_order_relaxed);
+            ++hits_;
+            return file;
+        }
+    }
+    ++misses_;
+    file = Load(path);
+    Insert(shard, path, file);
+    return file;
+}
+
+std::shared_ptr<const CachedFile> FileCache::GetCompressed(
+    const std::string& path,
+    const std::shared_ptr<const CachedFile>& origin,
+    ContentEncoding encoding) {
+    return GetCompressed(path, origin, encoding, false);
+}
+
+// 依次尝试：预先压缩好的文件（path 加上 .br、.gz 后缀，且不比源文件旧）-> 在内存中压缩的版本
+// 在内存中压缩的版本还没有时，交给后台线程去压缩，这期间（包括本次请求）得到空，发送原文件；
+// 同一个键同时只有一个压缩任务。best 为 true 时（启动时预先压缩）在当前线程中压缩
+std::shared_ptr<const CachedFile> FileCache::GetCompressed(
+    const std::string& path,
+    const std::shared_ptr<const CachedFile>& source,
+    ContentEncoding encoding,
+    bool best) {
+    assert(encoding != ContentEncoding::IDENTITY && source);
+    const CachedFile& origin = *source;
+    std::shared_ptr<const CachedFile> file = Get(path + EncodingSuffix(encoding));
+    if (file->exists && S_ISREG(file->st.st_mode) && (file->addr || file->fd >= 0) &&
+        IsNotOlder(file->st, origin.st)) {
+        return file;
+    }
+    if (compression_ == Compression::PRECOMPRESSED ||
+        !IsEncodingSupported(encoding) || !IsCompressible(origin.type) ||
+        origin.st.st_size < kMinCompressSize_) {
+        return nullptr;
+    }
+    // 压缩的结果以 path + '\0' + 后缀 为键缓存（不会与真实的路径冲突），源文件变化时重新压缩
+    std::string key = path + '\0' + EncodingSuffix(encoding);
+    Shard& shard = GetShard(key);
+    std::shared_ptr<CachedFile> compressed = Find(shard, key);
+    if (compressed && compressed->st.st_ino == origin.st.st_ino &&
+        compressed->source_size == origin.st.st_size &&
+        compressed->st.st_mtim.tv_sec == origin.st.st_mtim.tv_sec &&
+        compressed->st.st_mtim.tv_nsec == origin.st.st_mtim.tv_nsec) {
+        ++hits_;
+    } else {
+        ++misses_;
+        std::unique_lock<std::mutex> lck(shard.mtx);
+        auto [pending, inserted] = shard.compressing.insert(key);
+        if (!inserted) {
+            return nullptr;
+        }
+        lck.unlock();
+        if (!best) {
+            // 集合中的键在任务结束、将其移除之前地址不变，任务只保存它的指针
+            const std::string* pending_key = &*pending;
+            compress_pool_->AddTask(
+                [this, &shard, pending_key, source, encoding]() {
+                    Insert(shard, *pending_key,
+                           Compress(*source, encoding, false));
+                    std::lock_guard<std::mutex> lck(shard.mtx);
+                    shard.compressing.erase(shard.compressing.find(*pending_key));
+                });
+            return nullptr;
+        }
+        compressed = Compress(origin, encoding, true);
+        Insert(shard, key, compressed);
+        lck.lock();
+        shard.compressing.erase(key);
+    }
+    // 压缩失败或者压缩后没有变小（同样会被缓存，避免反复尝试）
+    if (!compressed->exists) {
+        return nullptr;
+    }
+    return compressed;
+}
+
+void FileCache::Precompress(const std::string& dir) {
+    if (compression_ == Compression::PRECOMPRESSED) {
+        return;
+    }
+    std::error_code ec;
+    size_t cnt = 0;
+    for (auto it = std::filesystem::recursive_directory_iterator(dir, ec);
+         !ec && it != std::filesystem::recursive_directory_iterator();
+         it.increment(ec)) {
+        if (!it->is_regular_file(ec)) {
+            continue;
+        }
+        std::string path = it->path().string();
+        std::shared_ptr<const CachedFile> origin = Get(path);
+        if (!origin->exists || !IsCompressible(origin->type)) {
+            continue;
+        }
+        for (ContentEncoding encoding :
+             {ContentEncoding::BROTLI, ContentEncoding::GZIP}) {
+            if (GetCompressed(path, origin, encoding, true)) {
+                ++cnt;
+            }
+        }
+    }
+    spdlog::info("Precompressed {} file variants in {}", cnt, dir);
+}
+
+// 文本类型的文件才值得压缩
+bool FileCache::IsCompressible(const std::string& type) {
+    return type.compare(0, 5, "text/") == 0 ||
+           type.find("javascript") != std::string::npos ||
+           type.find("json") != std::string::npos ||
+           type.find("xml") != std::string::npos;
+}
+
+// 是否能在内存中生成该编码的内容（取决于编译时是否链接了相应的压缩库）
+bool FileCache::IsEncodingSupported(ContentEncoding encoding) {
+    switch (encoding) {
+#ifdef WITH_ZLIB
+        case ContentEncoding::GZIP:
+            return true;
+#endif
+#ifdef WITH_BROTLI
+        case ContentEncoding::BROTLI:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+uint64_t FileCache::hits() const {
+    return hits_;
+}
+
+uint64_t FileCache::misses() const {
+    return misses_;
+}
+
+FileCache::Shard& FileCache::GetShard(const std::string& key) {
+    return shards_[std::hash<std::string>()(key) % kShardNum_];
+}
+
+// 查找缓存项，找到时将其移到 LRU 链表的表头
+std::shared_ptr<CachedFile> FileCache::Find(Shard& shard,
+                                            const std::string& key) {
+    std::lock_guard<std::mutex> lck(shard.mtx);
+    auto it = shard.index.find(key);
+    if (it == shard.index.end()) {
+        return nullptr;
+    }
+    shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+    return it->second->second;
+}
+
+// 加载文件：stat，然后按大小打开或映射到内存中
+std::shared_ptr<CachedFile> FileCache::Load(const std::string& path) const {
+    std::shared_ptr<CachedFile> file = std::make_shared<CachedFile>();
+    file->checked_at.store(Now(), std::memory_order_relaxed);
+    file->type = GetFileType(path);
+    file->exists = stat(path.c_str(), &file->st) == 0;
+    if (file->exists && S_ISREG(file->st.st_mode)) {
+        file->etag = MakeETag(file->st);
+        file->last_modified = FormatHttpDate(file->st.st_mtime);
+    }
+    if (!file->exists || !S_ISREG(file->st.st_mode) ||
+        !(file->st.st_mode & S_IROTH) || file->st.st_size == 0) {
+        return file;
+    }
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        spdlog::error("Open file {} error!", path);
+        return file;
+    }
+    if (sendfile_threshold_ >= 0 && file->st.st_size >= sendfile_threshold_) {
+        file->fd = fd;
+        return file;
+    }
+    void* addr = mmap(0, file->st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (addr != MAP_FAILED) {
+        file->addr = addr;
+    }
+    return file;
+}
+
+// 在内存中压缩源文件，压缩后的内容放在 content 中
+std::shared_ptr<CachedFile> FileCache::Compress(const CachedFile& origin,
+                                                ContentEncoding encoding,
+                                                bool best) const {
+    std::shared_ptr<CachedFile> file = std::make_shared<CachedFile>();
+    file->st = origin.st;
+    file->type = origin.type;
+    file->etag = origin.etag;
+    file->last_modified = origin.last_modified;
+    file->source_size = origin.st.st_size;
+    // 大文件没有映射到内存中，需要先读出来
+    std::string data;
+    const char* src = static_cast<const char*>(origin.addr);
+    if (!src && origin.fd >= 0) {
+        data.resize(origin.st.st_size);
+        if (pread(origin.fd, &data[0], data.size(), 0) !=
+            static_cast<ssize_t>(data.size())) {
+            return file;
+        }
+        src = data.data();
+    }
+    if (!src) {
+        return file;
+    }
+    bool ok = false;
+#ifdef WITH_ZLIB
+    if (encoding == ContentEncoding::GZIP) {
+        ok = GzipCompress(src, origin.st.st_size, best, &file->content);
+    }
+#endif
+#ifdef WITH_BROTLI
+    if (encoding == ContentEncoding::BROTLI) {
+        ok = BrotliCompress(src, origin.st.st_size, best, &file->content);
+    }
+#endif
+    if (ok && static_cast<off_t>(file->content.size()) < origin.st.st_size) {
+        file->exists = true;
+        file->st.st_size = file->content.size();
+        file->addr = &file->content[0];
+    } else {
+        file->content.clear();
+    }
+    return file;
+}
+
+void FileCache::Insert(Shard& shard,
+                       const std::string& key,
+                       const std::shared_ptr<CachedFile>& file) {
+    std::lock_guard<std::mutex> lck(shard.mtx);
+    auto it = shard.index.find(key);
+    if (it != shard.index.end()) {
+        // 替换失效的缓存项，旧的缓存项在最后一个使用者释放后销毁
+        it->second->second = file;
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+        return;
+    }
+    shard.lru.emplace_front(key, file);
+    shard.index[key] = shard.lru.begin();
+    // 容量满了，淘汰最久未使用的缓存项
+    while (shard.lru.size() > shard_capacity_) {
+        shard.index.erase(shard.lru.back().first);
+        shard.lru.pop_back();
+    }
+}
+
+bool FileCache::IsSame(const CachedFile& file,
+                       bool exists,
+                       const struct stat& st) {
+    if (!exists || !file.exists) {
+        return exists == file.exists;
+    }
+    return st.st_ino == file.st.st_ino && st.st_size == file.st.st_size &&
+           st.st_mode == file.st.st_mode &&
+           st.st_mtim.tv_sec == file.st.st_mtim.tv_sec &&
+           st.st_mtim.tv_nsec == file.st.st_mtim.tv_nsec;
+}
+
+// 根据文件名后缀推断文件类型
+std::string FileCache::GetFileType(const std::string& path) {
+    auto idx = path.find_last_of('.');
+    if (idx != std::string::npos) {
+        std::string suffix = path.substr(idx);
+        if (kSuffixTypes_.count(suffix)) {
+            return kSuffixTypes_.at(suffix);
+        }
+    }
+    return "text/plain";
+}
+
+int64_t FileCache::Now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
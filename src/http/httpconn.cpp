@@ -6,11 +6,25 @@
 
 std::string HttpConn::kWorkDir_;
 std::atomic<int> HttpConn::client_count_{};
+size_t HttpConn::kReadBudget_ = 256 * 1024;
+int HttpConn::kKeepAliveMax_ = 100;
 
 HttpConn::HttpConn() {
     sockfd_ = -1;
+    generation_ = 0;
     addr_ = {};
     is_closed_ = true;
+    is_keep_alive_ = false;
+    is_verifying_ = false;
+    read_paused_ = false;
+    phase_ = Phase::CONNECTED;
+    phase_since_ = last_read_ = last_write_ = 0;
+    busy_tasks_ = 0;
+    response_cnt_ = request_cnt_ = 0;
+    seg_idx_ = to_write_bytes_ = 0;
+    segments_.reserve(2 * kMaxPipelineDepth_);
+    iov_.reserve(2 * kMaxPipelineDepth_);
+    responses_.reset(new HttpResponse[kMaxPipelineDepth_]);
 }
 
 HttpConn::~HttpConn() {
@@ -24,28 +38,52 @@ void HttpConn::Init(int sockfd, const sockaddr_in& addr) {
     }
     addr_ = addr;
     sockfd_ = sockfd;
-    write_buff_.RetrieveAll();
+    ++generation_;
+    is_keep_alive_ = false;
+    is_verifying_ = false;
+    read_paused_ = false;
+    request_cnt_ = 0;
+    ClearResponses();
     read_buff_.RetrieveAll();
+    request_.Init();
+    phase_ = Phase::CONNECTED;
+    phase_since_ = last_read_ = last_write_ = TimerWheel::Now();
     is_closed_ = false;
-    spdlog::info("Client[{}]({}:{}) init. \t[client count:{}]", sockfd_, ip(),
+    SPDLOG_DEBUG("Client[{}]({}:{}) init. \t[client count:{}]", sockfd_, ip(),
                  port(), client_count_);
 }
 
 void HttpConn::Close() {
-    if (is_closed_) {
+    // 定时器和工作线程可能同时关闭同一个连接
+    if (is_closed_.exchange(true)) {
         return;
     }
-    is_closed_ = true;
     --client_count_;
     close(sockfd_);
-    spdlog::info("Client[{}]({}:{}) quit. \t[client count:{}]", sockfd_, ip(),
+    // 落盘的请求体不必等到槽位被复用（可能永远不会）才释放
+    request_.Release();
+    SPDLOG_DEBUG("Client[{}]({}:{}) quit. \t[client count:{}]", sockfd_, ip(),
                  port(), client_count_);
 }
 
+bool HttpConn::IsClosed() const {
+    return is_closed_;
+}
+
 int HttpConn::sockfd() const {
     return sockfd_;
 }
 
+uint32_t HttpConn::generation() const {
+    return generation_;
+}
+
+// 作为事件数据注册到 Epoller 中：高 32 位为 generation，低 32 位为 fd
+uint64_t HttpConn::tag() const {
+    return (static_cast<uint64_t>(generation_) << 32) |
+           static_cast<uint32_t>(sockfd_);
+}
+
 sockaddr_in HttpConn::addr() const {
     return addr_;
 }
@@ -58,106 +96,334 @@ int HttpConn::port() const {
     return addr_.sin_port;
 }
 
-//
+// 从 socket 中读数据
+// 正在接收请求体时，每读到一段就交给请求体的接收者并从读缓冲区中取走，大的上传不会占用连接的内存；
+// 请求体已经落盘、读缓冲区又没有剩余时，直接 splice 到临时文件中
+// 每次最多读入 kReadBudget_ 字节，响应尚未发完时读缓冲区中也最多积压这么多：
+// 一个不停发送数据的连接不会独占线程，也不会让读缓冲区无限增长
 ssize_t HttpConn::Read(int* save_errno) {
     ssize_t len = -1;
-    // ET 模式下需要读到不能再读
+    size_t total = 0;
+    read_paused_ = false;
+    // ET 模式下需要读到不能再读（或用完读预算）
     while (true) {
-        len = read_buff_.ReadFd(sockfd_, save_errno);
+        if (request_.CanSpliceBody(read_buff_)) {
+            len = request_.SpliceBody(sockfd_, save_errno);
+        } else {
+            len = read_buff_.ReadFd(sockfd_, save_errno);
+        }
         if (len <= 0) {
             break;
         }
+        total += len;
+        if (request_.state() == HttpRequest::ParseState::BODY) {
+            request_.Parse(read_buff_);
+        }
+        if (kReadBudget_ > 0 &&
+            (total >= kReadBudget_ ||
+             (to_write_bytes_ > 0 && read_buff_.ReadableBytes() >= kReadBudget_))) {
+            read_paused_ = true;
+            break;
+        }
+    }
+    if (total > 0) {
+        last_read_ = TimerWheel::Now();
     }
+    UpdatePhase();
     return len;
 }
 
-//
+// 发送所有排队的响应
+// 连续的内存段用一次 sendmsg（相当于 writev）发送，文件段用 sendfile 发送。
+// 内存段后面紧跟着文件段时带上 MSG_MORE，让响应头和文件内容合并成完整的报文段
 ssize_t HttpConn::Write(int* save_errno) {
-    ssize_t len = -1;
+    ssize_t len = 0;
     // ET 模式下需要写到不能再写
-    while (true) {
-        len = writev(sockfd_, iov_, iov_cnt_);
+    while (to_write_bytes_ > 0) {
+        BodySegment& seg = segments_[seg_idx_];
+        if (seg.data) {
+            len = WriteMemory();
+        } else {
+            len = sendfile(sockfd_, seg.fd, &seg.offset, seg.len);
+        }
         if (len == -1) {
             // 写到不能再写了（发送缓冲区已满）
             *save_errno = errno;
             break;
         }
-        if (ToWriteBytes() == 0) {
-            // 写完了
+        if (len == 0 && !seg.data) {
+            // 文件在缓存了它的大小之后被截断，sendfile 不会再有进展，只能关闭连接
+            spdlog::error("Client[{}] sendfile made no progress, file truncated?",
+                          sockfd_);
+            *save_errno = EIO;
+            len = -1;
             break;
         }
-        // 响应头部分的字节已经写入完毕
-        else if (static_cast<size_t>(len) > iov_[0].iov_len) {
-            iov_[1].iov_base = (uint8_t*)iov_[1].iov_base +
-                               (len - iov_[0].iov_len);
-            iov_[1].iov_len -= (len - iov_[0].iov_len);
-            if (iov_[0].iov_len) {
-                write_buff_.RetrieveAll();
-                iov_[0].iov_len = 0;
-            }
-        }
-        // 响应头部分的字节尚未写入完毕
-        else {
-            iov_[0].iov_base = (uint8_t*)iov_[0].iov_base + len;
-            iov_[0].iov_len -= len;
-            write_buff_.Retrieve(len);
-        }
+        Metrics::Add(Counter::BYTES_WRITTEN, len);
+        last_write_ = TimerWheel::Now();
+        Advance(len);
+    }
+    // 写完了，释放这一批响应
+    if (to_write_bytes_ == 0) {
+        ClearResponses();
     }
+    UpdatePhase();
     return len;
 }
 
-//
-bool HttpConn::Process() {
-    // 在完成上一个请求响应，但需要保持连接时，会进入到这个条件
-    // 重新初始化 HttpRequest 对象，准备下一次请求
-    if (request_.state() == HttpRequest::ParseState::FINISH) {
-        request_.Init();
+// 从当前数据段起，把连续的内存段一起发送出去
+ssize_t HttpConn::WriteMemory() {
+    iov_.clear();
+    size_t i = seg_idx_;
+    for (; i < segments_.size() && segments_[i].data && iov_.size() < IOV_MAX;
+         ++i) {
+        iov_.push_back({const_cast<char*>(segments_[i].data), segments_[i].len});
     }
+    msghdr msg{};
+    msg.msg_iov = iov_.data();
+    msg.msg_iovlen = iov_.size();
+    int flags = MSG_NOSIGNAL;
+    if (i < segments_.size()) {
+        flags |= MSG_MORE;
+    }
+    return sendmsg(sockfd_, &msg, flags);
+}
 
-    if (read_buff_.ReadableBytes() <= 0) {
-        return false;
+// 跳过已经写完的数据段，并调整写了一部分的数据段
+void HttpConn::Advance(size_t len) {
+    to_write_bytes_ -= len;
+    while (seg_idx_ < segments_.size() && len >= segments_[seg_idx_].len) {
+        len -= segments_[seg_idx_].len;
+        ++seg_idx_;
     }
+    if (len > 0) {
+        BodySegment& seg = segments_[seg_idx_];
+        seg.len -= len;
+        // 文件段的偏移已经由 sendfile 推进了
+        if (seg.data) {
+            seg.data += len;
+        }
+    }
+}
 
-    // 解析读缓冲区中的请求报文内容
-    HttpRequest::ParseResult http_code = request_.Parse(read_buff_);
-    switch (http_code) {
-        // 请求报文不完整，需要继续注册读事件
-        case HttpRequest::ParseResult::INCOMPLETE:
-            return false;
-            break;
-        // 请求报文解析出错，准备组装报告错误的响应报文
-        case HttpRequest::ParseResult::ERROR:
-            response_.Init(kWorkDir_, request_.url(), false, 400);
-            break;
-        // 请求报文解析完毕，准备组装正常的响应报文
-        case HttpRequest::ParseResult::COMPLETE:
-            response_.Init(kWorkDir_, request_.url(), request_.IsKeepAlive(), 200);
+// 解析读缓冲区中所有完整的请求报文，并按顺序为它们组装响应报文
+// 登录、注册请求需要先验证用户：之前的响应先发送出去，之后挂起该连接（返回 VERIFY），
+// 直到 FinishVerify 为它组装好响应，再继续处理后续的请求
+HttpConn::ProcessResult HttpConn::Process() {
+    // 上一批响应尚未发送完毕，先把它们发完，再处理后续的请求（保证响应的顺序）
+    if (to_write_bytes_ > 0) {
+        return ProcessResult::WRITE;
+    }
+    if (is_verifying_) {
+        return ProcessResult::VERIFYING;
+    }
+    // 连接将被关闭时，之后的请求不再处理
+    while (response_cnt_ < kMaxPipelineDepth_ &&
+           (response_cnt_ == 0 || is_keep_alive_)) {
+        // 等待验证的请求已经解析完毕，否则解析下一个请求
+        if (!request_.NeedsVerify()) {
+            // 没有新的请求（请求体可能已在 Read 中接收完毕，此时读缓冲区为空）
+            if (read_buff_.ReadableBytes() == 0 &&
+                request_.state() == HttpRequest::ParseState::START_LINE) {
+                break;
+            }
+            // 解析读缓冲区中的请求报文内容
+            int64_t start = Metrics::Now();
+            HttpRequest::ParseResult http_code = request_.Parse(read_buff_);
+            Metrics::Observe(Histogram::PARSE, Metrics::Now() - start);
+            // 请求报文不完整，需要继续读
+            if (http_code == HttpRequest::ParseResult::INCOMPLETE) {
+                // 之前的响应都已发送完毕时才能发送 100 Continue，否则等它们发送完毕后再发
+                if (response_cnt_ == 0 && request_.TakeExpectContinue()) {
+                    SendContinue();
+                }
+                break;
+            }
+            if (!request_.NeedsVerify()) {
+                AddResponse(http_code);
+                continue;
+            }
+        }
+        if (response_cnt_ > 0) {
             break;
+        }
+        is_verifying_ = true;
+        UpdatePhase();
+        return ProcessResult::VERIFY;
+    }
+    if (response_cnt_ == 0) {
+        UpdatePhase();
+        return ProcessResult::READ;
     }
 
-    // 开始组装响应报文
-    // 响应头
-    response_.MakeResponse(write_buff_);
-    iov_[0].iov_base = const_cast<char*>(write_buff_.ReadBegin());
-    iov_[0].iov_len = write_buff_.ReadableBytes();
-    iov_cnt_ = 1;
+    // 所有响应头都追加完毕后，按长度从写缓冲区的各个块中切分出来
+    // 一个响应头可能跨越两个块，此时对应两个相邻的内存段，仍然由一次 sendmsg 发送
+    int idx = 0;
+    size_t left = header_lens_[0];
+    write_buff_.ForEachChunk([&](const char* data, size_t len) {
+        while (len > 0) {
+            size_t n = std::min(len, left);
+            segments_.push_back({data, -1, 0, n});
+            data += n;
+            len -= n;
+            left -= n;
+            if (left == 0) {
+                responses_[idx].AppendBody(&segments_);
+                if (++idx < response_cnt_) {
+                    left = header_lens_[idx];
+                }
+            }
+        }
+    });
+    assert(idx == response_cnt_);
+    for (const BodySegment& seg : segments_) {
+        to_write_bytes_ += seg.len;
+    }
+    SPDLOG_DEBUG("Client[{}]({}:{})  responses: {}, segments: {},  ToWriteBytes: {}",
+                 sockfd_, ip(), port(), response_cnt_, segments_.size(),
+                 to_write_bytes_);
+    UpdatePhase();
+    return ProcessResult::WRITE;
+}
 
-    // 文件（响应体）
-    if (response_.file_size() > 0 && response_.file_addr()) {
-        iov_[1].iov_base = response_.file_addr();
-        iov_[1].iov_len = response_.file_size();
-        iov_cnt_ = 2;
+// 验证完成：为等待验证的请求组装响应，之后由调用者再次调用 Process
+void HttpConn::FinishVerify(bool ok) {
+    // 连接可能已被关闭并复用
+    if (!is_verifying_) {
+        return;
+    }
+    is_verifying_ = false;
+    request_.SetVerifyResult(ok);
+    AddResponse(HttpRequest::ParseResult::COMPLETE);
+}
+
+const HttpRequest& HttpConn::request() const {
+    return request_;
+}
+
+// 为刚刚解析完的请求组装响应，并将请求报文从读缓冲区中取走
+void HttpConn::AddResponse(HttpRequest::ParseResult http_code) {
+    HttpResponse& response = responses_[response_cnt_];
+    Metrics::Add(Counter::REQUESTS);
+    // 处理完 kKeepAliveMax_ 个请求后关闭连接，最后一个响应带上 Connection: close
+    ++request_cnt_;
+    int left = kKeepAliveMax_ > 0 ? kKeepAliveMax_ - request_cnt_ : 0;
+    is_keep_alive_ = http_code == HttpRequest::ParseResult::COMPLETE &&
+                     request_.IsKeepAlive() && (kKeepAliveMax_ <= 0 || left > 0);
+    if (http_code == HttpRequest::ParseResult::ERROR) {
+        // 请求报文解析出错（或超出限制），准备组装报告错误的响应报文
+        response.Init(kWorkDir_, request_.url(), false, request_.error_code());
+    } else {
+        // 请求报文解析完毕，准备组装正常的响应报文
+        response.Init(kWorkDir_, request_.url(), is_keep_alive_, 200, left);
+    }
+    // 响应头追加到写缓冲区中，响应体稍后以数据段的形式追加
+    size_t readable = write_buff_.ReadableBytes();
+    response.MakeResponse(write_buff_, request_);
+    header_lens_[response_cnt_++] = write_buff_.ReadableBytes() - readable;
+    AccessLog::Log(addr_, request_.method(), request_.url(), request_.version(),
+                   response.code(), response.body_size());
+    // 请求报文已处理完毕，从读缓冲区中取走，并重新初始化 HttpRequest 对象，准备解析下一个请求
+    request_.Retrieve(read_buff_);
+    request_.Init();
+}
+
+// 告诉客户可以发送请求体了：只有一行状态行，发送缓冲区此时是空的，不会写不完
+void HttpConn::SendContinue() {
+    static constexpr char kContinue[] = "HTTP/1.1 100 Continue\r\n\r\n";
+    if (send(sockfd_, kContinue, sizeof(kContinue) - 1, MSG_NOSIGNAL) !=
+        static_cast<ssize_t>(sizeof(kContinue) - 1)) {
+        spdlog::warn("Client[{}] failed to send 100 Continue", sockfd_);
     }
-    spdlog::debug(
-        "Client[{}]({}:{})  filesize: {}, iov_cnt: {},  ToWriteBytes: {}",
-        sockfd_, ip(), port(), response_.file_size(), iov_cnt_, ToWriteBytes());
-    return true;
 }
 
 int HttpConn::ToWriteBytes() {
-    return iov_[0].iov_len + iov_[1].iov_len;
+    return to_write_bytes_;
 }
 
 bool HttpConn::IsKeepAlive() const {
-    return request_.IsKeepAlive();
+    return is_keep_alive_;
+}
+
+TimerNode* HttpConn::timer_node() {
+    return &timer_node_;
+}
+
+HttpConn::Phase HttpConn::phase() const {
+    return phase_;
+}
+
+int64_t HttpConn::phase_since() const {
+    return phase_since_;
+}
+
+int64_t HttpConn::last_read() const {
+    return last_read_;
+}
+
+int64_t HttpConn::last_write() const {
+    return last_write_;
+}
+
+bool HttpConn::IsVerifying() const {
+    return is_verifying_;
+}
+
+bool HttpConn::IsReadPaused() const {
+    return read_paused_;
+}
+
+void HttpConn::BeginTask() {
+    busy_tasks_.fetch_add(1, std::memory_order_relaxed);
+}
+
+// 工作线程对该连接的最后一次访问，之前的所有修改对 IsBusy 返回 false 的 Reactor 线程可见
+void HttpConn::EndTask() {
+    busy_tasks_.fetch_sub(1, std::memory_order_release);
+}
+
+bool HttpConn::IsBusy() const {
+    return busy_tasks_.load(std::memory_order_acquire) > 0;
+}
+
+void HttpConn::SendRequestTimeout() {
+    static constexpr char kTimeout[] =
+        "HTTP/1.1 408 Request Timeout\r\nConnection: close\r\n"
+        "Content-length: 0\r\n\r\n";
+    send(sockfd_, kTimeout, sizeof(kTimeout) - 1, MSG_NOSIGNAL | MSG_DONTWAIT);
+}
+
+// 由连接当前的状态推出所处的阶段，阶段改变时记下时刻
+// 读缓冲区中有数据（或已解析了一部分）时即开始接收请求，新连接在收到数据前保持 CONNECTED
+void HttpConn::UpdatePhase() {
+    Phase phase;
+    if (to_write_bytes_ > 0) {
+        phase = Phase::WRITE;
+    } else if (is_verifying_) {
+        phase = Phase::VERIFY;
+    } else if (request_.state() == HttpRequest::ParseState::BODY) {
+        phase = Phase::BODY;
+    } else if (read_buff_.ReadableBytes() > 0 ||
+               request_.state() != HttpRequest::ParseState::START_LINE) {
+        phase = Phase::HEADERS;
+    } else if (phase_ == Phase::CONNECTED) {
+        phase = Phase::CONNECTED;
+    } else {
+        phase = Phase::IDLE;
+    }
+    if (phase != phase_) {
+        phase_since_ = TimerWheel::Now();
+        phase_ = phase;
+    }
+}
+
+// 释放已发送完毕（或被丢弃）的响应
+void HttpConn::ClearResponses() {
+    for (int i = 0; i < response_cnt_; ++i) {
+        responses_[i].ReleaseFile();
+    }
+    response_cnt_ = 0;
+    segments_.clear();
+    seg_idx_ = to_write_bytes_ = 0;
+    write_buff_.RetrieveAll();
 }
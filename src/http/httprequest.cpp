@@ -3,6 +3,12 @@
 
 #include "http/httprequest.h"
 
+#include <strings.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
 // 保存默认页面名的静态变量，所有对以下 url 的请求都会加上 .html 后缀
 const std::unordered_set<std::string> HttpRequest::kDefaultHtml_{
     "/index", "/register", "/login", "/welcome", "/video", "/picture",
@@ -14,6 +20,11 @@ const std::unordered_map<std::string, int> HttpRequest::kDefaultHtmlTag_{
     {"/login.html", 1},
 };
 
+size_t HttpRequest::kMaxStartLine_ = 8 * 1024;
+size_t HttpRequest::kMaxHeaderBytes_ = 32 * 1024;
+size_t HttpRequest::kMaxHeaders_ = 100;
+size_t HttpRequest::kMaxBodySize_ = 1 << 30;
+
 // 构造时请求信息默认初始化为空
 HttpRequest::HttpRequest() {
     Init();
@@ -22,9 +33,26 @@ HttpRequest::HttpRequest() {
 // 将各请求信息重新初始化为空
 void HttpRequest::Init() {
     state_ = ParseState::START_LINE;
-    method_ = url_ = version_ = body_ = "";
+    buff_ = nullptr;
+    line_begin_ = scan_pos_ = headers_off_ = 0;
+    content_length_ = body_left_ = body_total_ = 0;
+    is_chunked_ = expects_continue_ = false;
+    error_code_ = 400;
+    chunk_state_ = ChunkState::SIZE;
+    is_keep_alive_ = false;
+    needs_verify_ = is_login_ = false;
+    method_ = version_ = body_ = {};
+    url_ = "";
+    head_.clear();
     headers_.clear();
     post_request_parms_.clear();
+    body_store_.Clear();
+}
+
+void HttpRequest::Release() {
+    Init();
+    body_store_.Reset();
+    body_handler_ = nullptr;
 }
 
 std::string HttpRequest::url() const {
@@ -35,25 +63,221 @@ std::string& HttpRequest::url() {
     return url_;
 }
 
-std::string HttpRequest::method() const {
-    return method_;
+std::string_view HttpRequest::method() const {
+    return View(method_);
+}
+
+std::string_view HttpRequest::version() const {
+    return View(version_);
+}
+
+// 边接收边处理的请求体保存在 BodyStore 中（落盘时为空），否则仍在读缓冲区中
+std::string_view HttpRequest::body() const {
+    if (!head_.empty()) {
+        return body_store_.data();
+    }
+    return View(body_);
 }
 
-std::string HttpRequest::version() const {
-    return version_;
+// 按名称（不区分大小写）获取请求头的值，不存在时返回空
+std::string_view HttpRequest::GetHeader(std::string_view name) const {
+    for (const Header& header : headers_) {
+        if (header.name.len == name.size() &&
+            strncasecmp(View(header.name).data(), name.data(), name.size()) ==
+                0) {
+            return View(header.value);
+        }
+    }
+    return {};
 }
 
 HttpRequest::ParseState HttpRequest::state() const {
     return state_;
 }
 
+int HttpRequest::error_code() const {
+    return error_code_;
+}
+
 bool HttpRequest::IsKeepAlive() const {
-    if (headers_.count("Connection") == 1) {
-        return headers_.at("Connection") == "keep-alive" && version_ == "1.1";
+    return is_keep_alive_;
+}
+
+// Connection 是逗号分隔的选项列表（如 "keep-alive, Upgrade"），选项不区分大小写
+bool HttpRequest::HasConnectionOption(std::string_view option) const {
+    std::string_view list = GetHeader("Connection");
+    while (!list.empty()) {
+        size_t comma = list.find(',');
+        std::string_view item = list.substr(0, comma);
+        list = comma == std::string_view::npos ? std::string_view()
+                                               : list.substr(comma + 1);
+        while (!item.empty() && (item.front() == ' ' || item.front() == '\t')) {
+            item.remove_prefix(1);
+        }
+        while (!item.empty() && (item.back() == ' ' || item.back() == '\t')) {
+            item.remove_suffix(1);
+        }
+        if (item.size() == option.size() &&
+            strncasecmp(item.data(), option.data(), option.size()) == 0) {
+            return true;
+        }
     }
     return false;
 }
 
+// 客户是否接受指定的内容编码：Accept-Encoding 中列出了该编码（或者 *），且 q 不为 0
+// 形如 "gzip, deflate, br;q=0.9, *;q=0"，明确列出的编码优先于 *
+bool HttpRequest::AcceptsEncoding(std::string_view coding) const {
+    std::string_view list = GetHeader("Accept-Encoding");
+    bool wildcard = false;
+    while (!list.empty()) {
+        size_t comma = list.find(',');
+        std::string_view item = list.substr(0, comma);
+        list = comma == std::string_view::npos ? std::string_view()
+                                               : list.substr(comma + 1);
+        size_t semicolon = item.find(';');
+        std::string_view name = item.substr(0, semicolon);
+        while (!name.empty() && (name.front() == ' ' || name.front() == '\t')) {
+            name.remove_prefix(1);
+        }
+        while (!name.empty() && (name.back() == ' ' || name.back() == '\t')) {
+            name.remove_suffix(1);
+        }
+        bool acceptable = true;
+        if (semicolon != std::string_view::npos) {
+            std::string_view params = item.substr(semicolon + 1);
+            size_t q = params.find("q=");
+            if (q != std::string_view::npos) {
+                acceptable = atof(std::string(params.substr(q + 2)).c_str()) > 0;
+            }
+        }
+        if (name.size() == coding.size() &&
+            strncasecmp(name.data(), coding.data(), coding.size()) == 0) {
+            return acceptable;
+        }
+        if (name == "*") {
+            wildcard = acceptable;
+        }
+    }
+    return wildcard;
+}
+
+// 解析 Range 请求头（只支持 bytes 单位），形如 "bytes=0-499, 1000-, -500"
+// 没有 Range 或者格式有误时返回 false，此时应当忽略 Range，发送整个文件
+bool HttpRequest::GetRanges(std::vector<ByteRange>* ranges) const {
+    assert(ranges);
+    std::string_view value = GetHeader("Range");
+    if (value.size() < 6 || strncasecmp(value.data(), "bytes=", 6) != 0) {
+        return false;
+    }
+    value.remove_prefix(6);
+    ranges->clear();
+    // 解析一个非负整数，没有数字时返回 -1
+    auto parse_number = [](std::string_view& str) -> int64_t {
+        int64_t num = -1;
+        while (!str.empty() && str.front() >= '0' && str.front() <= '9') {
+            if (num > (INT64_MAX - 9) / 10) {
+                return -2;  // 溢出，视为格式有误
+            }
+            num = (num < 0 ? 0 : num * 10) + (str.front() - '0');
+            str.remove_prefix(1);
+        }
+        return num;
+    };
+    while (true) {
+        while (!value.empty() && (value.front() == ' ' || value.front() == '\t')) {
+            value.remove_prefix(1);
+        }
+        ByteRange range;
+        range.first = parse_number(value);
+        if (range.first == -2 || value.empty() || value.front() != '-') {
+            return false;
+        }
+        value.remove_prefix(1);
+        range.last = parse_number(value);
+        if (range.last == -2 || (range.first < 0 && range.last < 0) ||
+            (range.last >= 0 && range.first > range.last)) {
+            return false;
+        }
+        ranges->push_back(range);
+        while (!value.empty() && (value.front() == ' ' || value.front() == '\t')) {
+            value.remove_prefix(1);
+        }
+        if (value.empty()) {
+            return true;
+        }
+        if (value.front() != ',') {
+            return false;
+        }
+        value.remove_prefix(1);
+    }
+}
+
+// 条件 GET：客户缓存的版本（由 etag、mtime 描述）是否仍然有效
+// 有 If-None-Match 时按实体标签弱比较（忽略 W/ 前缀），忽略 If-Modified-Since
+bool HttpRequest::IsNotModified(std::string_view etag, time_t mtime) const {
+    if (method() != "GET") {
+        return false;
+    }
+    std::string_view list = GetHeader("If-None-Match");
+    if (!list.empty()) {
+        if (etag.substr(0, 2) == "W/") {
+            etag.remove_prefix(2);
+        }
+        while (!list.empty()) {
+            size_t comma = list.find(',');
+            std::string_view tag = list.substr(0, comma);
+            list = comma == std::string_view::npos ? std::string_view()
+                                                   : list.substr(comma + 1);
+            while (!tag.empty() && (tag.front() == ' ' || tag.front() == '\t')) {
+                tag.remove_prefix(1);
+            }
+            while (!tag.empty() && (tag.back() == ' ' || tag.back() == '\t')) {
+                tag.remove_suffix(1);
+            }
+            if (tag.substr(0, 2) == "W/") {
+                tag.remove_prefix(2);
+            }
+            if (tag == "*" || (!tag.empty() && tag == etag)) {
+                return true;
+            }
+        }
+        return false;
+    }
+    std::string_view since = GetHeader("If-Modified-Since");
+    time_t t;
+    return !since.empty() && ParseHttpDate(since, &t) && mtime <= t;
+}
+
+// 解析 HTTP 日期（IMF-fixdate），形如 "Sun, 06 Nov 1994 08:49:37 GMT"
+bool HttpRequest::ParseHttpDate(std::string_view value, time_t* t) {
+    assert(t);
+    std::string str(value);
+    struct tm tm = {};
+    const char* end = strptime(str.c_str(), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+    if (!end || *end != '\0') {
+        return false;
+    }
+    *t = timegm(&tm);
+    return *t != -1;
+}
+
+// 是否为尚未完成验证的登录、注册请求
+bool HttpRequest::NeedsVerify() const {
+    return needs_verify_;
+}
+
+bool HttpRequest::IsLogin() const {
+    return is_login_;
+}
+
+// 根据（异步）验证的结果改写 url
+void HttpRequest::SetVerifyResult(bool ok) {
+    assert(needs_verify_);
+    needs_verify_ = false;
+    url_ = ok ? "/welcome.html" : "/error.html";
+}
+
 // 按关键字获取指定 Post 请求参数
 std::string HttpRequest::GetPostRequestParm(const std::string& key) const {
     assert(key != "");
@@ -63,63 +287,151 @@ std::string HttpRequest::GetPostRequestParm(const std::string& key) const {
     return "";
 }
 
+void HttpRequest::SetBodyHandler(BodyHandler handler) {
+    body_handler_ = std::move(handler);
+}
+
+const BodyStore& HttpRequest::body_store() const {
+    return body_store_;
+}
+
+bool HttpRequest::TakeExpectContinue() {
+    bool expects = expects_continue_;
+    expects_continue_ = false;
+    return expects;
+}
+
+bool HttpRequest::CanSpliceBody(const Buffer& buff) const {
+    return state_ == ParseState::BODY && body_left_ > 0 && !body_handler_ &&
+           body_store_.IsSpilled() && buff.ReadableBytes() == 0 &&
+           (!is_chunked_ || chunk_state_ == ChunkState::DATA);
+}
+
+ssize_t HttpRequest::SpliceBody(int fd, int* save_errno) {
+    assert(body_left_ > 0);
+    ssize_t len = body_store_.Splice(fd, body_left_, save_errno);
+    if (len > 0) {
+        body_left_ -= len;
+    }
+    return len;
+}
+
 // 解析请求报文（重点理解）
+// 解析过程中不会取走读缓冲区中的数据，请求行、请求头、请求体都以偏移量记录。
+// 只有待解析的数据跨越了读缓冲区的多个块时，才会先把它们合并到一个块中。
+// 数据分多次到达时，从上次停下的位置继续扫描，不会重新扫描已经看过的字节。
+// 请求报文处理完毕后，需要调用 Retrieve 将其从读缓冲区中取走。
+// 例外是尚未全部到达（或较大、分块传输）的请求体：见 StartBody
 HttpRequest::ParseResult HttpRequest::Parse(Buffer& buff) {
-    const char CRLF[] = "\r\n";
-    // 如果读缓冲区中没有内容可以被读取，返回 INCOMPLETE，需要重置 EPOLLIN
-    // 等下次再读
-    if (buff.ReadableBytes() == 0) {
-        return ParseResult::INCOMPLETE;
-    }
-
-    // 状态机解析请求报文
-    while (buff.ReadableBytes() && state_ != ParseState::FINISH) {
-        // 尝试从读缓冲区中提取出一行
-        const char* line_end = std::search(
-            buff.ReadBegin(), buff.ConstWriteBegin(), CRLF, CRLF + 2);
-        // 如果找不到 CRLF，并且当前状态不是解析请求体，说明 line
-        // 并不是一个有效的行，返回 INCOMPLETE，需要重置 EPOLLIN 等下次再读
-        if (line_end == buff.ConstWriteBegin() && state_ != ParseState::BODY) {
+    buff_ = &buff;
+    if (state_ == ParseState::ERROR) {
+        return ParseResult::ERROR;
+    }
+    if (state_ == ParseState::BODY) {
+        return ParseBody(buff);
+    }
+    if (state_ == ParseState::FINISH) {
+        return ParseResult::COMPLETE;
+    }
+    const char* begin = buff.Linearize();
+    const size_t readable = buff.ReadableBytes();
+
+    // 状态机解析请求行、请求头
+    while (state_ != ParseState::FINISH) {
+        // 尝试从读缓冲区中提取出一行，找不到行尾说明数据还不完整
+        const char* line_end = static_cast<const char*>(
+            memchr(begin + scan_pos_, '\n', readable - scan_pos_));
+        if (!line_end) {
+            scan_pos_ = readable;
+            // 不等行尾到达：超出限制的请求行、请求头不会在读缓冲区中越积越多
+            if (state_ == ParseState::START_LINE &&
+                readable - line_begin_ > kMaxStartLine_) {
+                return Fail(414);
+            }
+            if (state_ == ParseState::HEADERS &&
+                readable - headers_off_ > kMaxHeaderBytes_) {
+                return Fail(431);
+            }
             return ParseResult::INCOMPLETE;
         }
-        std::string line(buff.ReadBegin(), line_end);
+        const char* line_begin = begin + line_begin_;
+        const char* content_end = line_end;
+        if (content_end > line_begin && content_end[-1] == '\r') {
+            --content_end;
+        }
+        scan_pos_ = line_end - begin + 1;
         // 根据当前状态决定解析方式
         switch (state_) {
             // 解析请求行
             case ParseState::START_LINE:
-                if (!ParseStartLine(line)) {
-                    return ParseResult::ERROR;
+                if (static_cast<size_t>(content_end - line_begin) > kMaxStartLine_) {
+                    return Fail(414);
+                }
+                if (!ParseStartLine(line_begin, content_end)) {
+                    return Fail();
                 }
                 ParseUrl();  // 将默认 url 补充完整
+                headers_off_ = scan_pos_;
                 break;
-            // 解析请求头
+            // 解析请求头，遇到空行时请求头结束
             case ParseState::HEADERS:
-                if (!ParseHeaders(line)) {
-                    return ParseResult::ERROR;
+                if (scan_pos_ - headers_off_ > kMaxHeaderBytes_) {
+                    return Fail(431);
                 }
-                // ParseHeaders 在遇到空行时会将 state_ 置为 BODY
-                // 如果是 GET 请求，就解析完毕了
-                if (state_ == ParseState::BODY && method_ == "GET") {
-                    state_ = ParseState::FINISH;
-                    buff.RetrieveAll();
-                    return ParseResult::COMPLETE;
+                if (line_begin != content_end) {
+                    if (headers_.size() >= kMaxHeaders_) {
+                        return Fail(431);
+                    }
+                    if (!ParseHeader(line_begin, content_end)) {
+                        return Fail();
+                    }
+                    break;
                 }
-                break;
-            // 解析请求体
-            case ParseState::BODY:
-                if (!ParseBody(line)) {
-                    return ParseResult::INCOMPLETE;
+                if (!ParseContentLength()) {
+                    return Fail();
                 }
-                buff.RetrieveAll();
-                return ParseResult::COMPLETE;
-                break;
+                // 请求体过大时不等它到达就报告错误
+                if (kMaxBodySize_ > 0 && content_length_ > kMaxBodySize_) {
+                    return Fail(413);
+                }
+                body_.off = scan_pos_;
+                // 不大的请求体已经全部到达时，直接在读缓冲区中访问
+                if (!is_chunked_ && !body_handler_ &&
+                    content_length_ <= BodyStore::kSpillThreshold_ &&
+                    readable - body_.off >= content_length_) {
+                    body_.len = content_length_;
+                    FinishParse();
+                    break;
+                }
+                StartBody(buff);
+                return ParseBody(buff);
             default:
                 break;
         }
-        buff.RetrieveUntil(line_end + 2);
+        line_begin_ = scan_pos_;
+    }
+    SPDLOG_DEBUG("[{}], [{}], [{}]", method(), url_, version());
+    return ParseResult::COMPLETE;
+}
+
+// 将处理完毕的请求报文从读缓冲区中取走（之后的请求报文留待下一次解析）
+// 此后 method、version、请求头等视图均失效
+void HttpRequest::Retrieve(Buffer& buff) {
+    if (state_ == ParseState::FINISH) {
+        // 边接收边处理的请求体已经随解析取走了
+        if (head_.empty()) {
+            buff.Retrieve(body_.off + body_.len);
+        }
+    } else {
+        buff.RetrieveAll();  // 请求报文有误，后续的数据也无从解析
     }
-    spdlog::debug("[{}], [{}], [{}]", method_, url_, version_);
-    return ParseResult::INCOMPLETE;
+    buff_ = nullptr;
+}
+
+HttpRequest::ParseResult HttpRequest::Fail(int code) {
+    state_ = ParseState::ERROR;
+    error_code_ = code;
+    return ParseResult::ERROR;
 }
 
 // 将默认 url 补充完整
@@ -134,196 +446,322 @@ void HttpRequest::ParseUrl() {
     }
 }
 
-// 解析请求行
-bool HttpRequest::ParseStartLine(const std::string& line) {
-    std::regex pattern("^([^ ]*) ([^ ]*) HTTP/([^ ]*)$");
-    std::smatch sub_match;
-    if (std::regex_match(line, sub_match, pattern)) {
-        method_ = sub_match[1];
-        url_ = sub_match[2];
-        version_ = sub_match[3];
-        state_ = ParseState::HEADERS;  // 切换状态
-        return true;
-    }
-    spdlog::error("StartLine Error! {}", line);
-    return false;
-}
-
-// 解析请求头
-bool HttpRequest::ParseHeaders(const std::string& line) {
-    std::regex pattern("^([^:]*): ?(.*)$");
-    std::smatch sub_match;
-    if (std::regex_match(line, sub_match, pattern)) {
-        headers_[sub_match[1]] = sub_match[2];
-    } else if (line == "") {
-        state_ = ParseState::BODY;
-    } else {
-        spdlog::error("Headers Error! {}", line);
+// 解析请求行：方法 SP URL SP HTTP/版本号
+// 方法须由 token 字符组成；URL 中 '?' 之后的查询字符串不参与查找文件
+bool HttpRequest::ParseStartLine(const char* begin, const char* end) {
+    const char* sp1 = ByteScan::FindNonToken(begin, end);
+    const char* sp2 =
+        sp1 < end && *sp1 == ' '
+            ? static_cast<const char*>(memchr(sp1 + 1, ' ', end - sp1 - 1))
+            : nullptr;
+    const char* ver = sp2 ? sp2 + 1 : nullptr;
+    if (!sp2 || sp1 == begin || sp2 == sp1 + 1 || end - ver <= 5 ||
+        memcmp(ver, "HTTP/", 5) != 0 || memchr(ver, ' ', end - ver)) {
+        spdlog::error("StartLine Error! {}", std::string_view(begin, end - begin));
         return false;
     }
+    method_ = ToField(begin, sp1);
+    const char* query = static_cast<const char*>(memchr(sp1 + 1, '?', sp2 - sp1 - 1));
+    url_.assign(sp1 + 1, query ? query : sp2);
+    version_ = ToField(ver + 5, end);
+    state_ = ParseState::HEADERS;  // 切换状态
     return true;
 }
 
-// 解析请求体
-bool HttpRequest::ParseBody(const std::string& line) {
-    if (line.size() < stoi(headers_.at("Content-Length"))) {
+// 解析一行请求头：名称 ":" 空白 值 空白
+// 名称须由 token 字符组成，且紧跟着 ':'（"Host : x" 这样的请求头会被拒绝，避免与代理的理解不一致）
+bool HttpRequest::ParseHeader(const char* begin, const char* end) {
+    const char* colon = ByteScan::FindNonToken(begin, end);
+    if (colon == end || *colon != ':' || colon == begin) {
+        spdlog::error("Headers Error! {}", std::string_view(begin, end - begin));
         return false;
     }
-    body_ = line;
-    ParsePost();
-    state_ = ParseState::FINISH;
-    spdlog::debug("Body:{}, len:{}", line, line.size());
+    const char* value_begin = colon + 1;
+    while (value_begin < end && (*value_begin == ' ' || *value_begin == '\t')) {
+        ++value_begin;
+    }
+    const char* value_end = end;
+    while (value_end > value_begin &&
+           (value_end[-1] == ' ' || value_end[-1] == '\t')) {
+        --value_end;
+    }
+    headers_.push_back({ToField(begin, colon), ToField(value_begin, value_end)});
     return true;
 }
 
-// 解析 Post 请求
-void HttpRequest::ParsePost() {
-    if (method_ == "POST" &&
-        headers_["Content-Type"] == "application/x-www-form-urlencoded") {
-        // 将请求体解析成 Post 请求参数
-        ParseFromUrlencoded();
-        // 处理登录注册请求
-        if (kDefaultHtmlTag_.count(url_)) {
-            int tag = kDefaultHtmlTag_.at(url_);
-            spdlog::debug("Tag:{}", tag);
-            if (tag == 0 || tag == 1) {
-                bool is_login = (tag == 1);
-                if (UserVerify(post_request_parms_["username"],
-                               post_request_parms_["password"], is_login)) {
-                    url_ = "/welcome.html";
-                } else {
-                    url_ = "/error.html";
-                }
-            }
+// 请求头结束时确定请求体的长度：分块传输，或者由 Content-Length 决定，都没有时视为没有请求体
+// 只支持 chunked 一种传输编码；同时带有两者的请求报文可能被前面的代理按另一种方式分割（请求走私），直接拒绝
+bool HttpRequest::ParseContentLength() {
+    std::string_view encoding = GetHeader("Transfer-Encoding");
+    std::string_view value = GetHeader("Content-Length");
+    content_length_ = 0;
+    if (!encoding.empty()) {
+        is_chunked_ = encoding.size() == 7 &&
+                      strncasecmp(encoding.data(), "chunked", 7) == 0 &&
+                      value.empty();
+        if (!is_chunked_) {
+            spdlog::error("Transfer-Encoding Error! {}", encoding);
         }
+        return is_chunked_;
     }
+    if (value.empty()) {
+        return true;
+    }
+    for (char ch : value) {
+        if (ch < '0' || ch > '9') {
+            spdlog::error("Content-Length Error! {}", value);
+            return false;
+        }
+        // 超过 4GB 的长度不再累加，有长度限制时按超出限制处理（413），否则按格式错误处理
+        if (content_length_ <= (UINT32_MAX - 9) / 10) {
+            content_length_ = content_length_ * 10 + (ch - '0');
+        } else {
+            content_length_ = SIZE_MAX;
+        }
+    }
+    return content_length_ != SIZE_MAX || kMaxBodySize_ > 0;
 }
 
-// 将 16 进制数转为 10 进制数
-int HttpRequest::ConvertHexToDecimal(char ch) {
-    if (ch >= 'A' && ch <= 'F')
-        return ch - 'A' + 10;
-    if (ch >= 'a' && ch <= 'f')
-        return ch - 'a' + 10;
-    return ch;
+// 开始边接收边处理请求体：请求行、请求头复制到 head_ 中，之后从读缓冲区中取走，
+// 请求体每到达一段就交给接收者并取走，读缓冲区不会随请求体增长
+void HttpRequest::StartBody(Buffer& buff) {
+    std::string_view expect = GetHeader("Expect");
+    head_.assign(buff.ReadBegin(), body_.off);
+    buff.Retrieve(body_.off);
+    body_ = {};
+    line_begin_ = scan_pos_ = 0;
+    body_left_ = content_length_;
+    chunk_state_ = ChunkState::SIZE;
+    // 请求体一个字节都还没有到达时，客户可能在等待 100 Continue
+    expects_continue_ = version() == "1.1" && buff.ReadableBytes() == 0 &&
+                        expect.size() == 12 &&
+                        strncasecmp(expect.data(), "100-continue", 12) == 0;
+    state_ = ParseState::BODY;
 }
 
-// 从 ContentType = application/x-www-form-urlencoded 的请求体中解析请求参数
-void HttpRequest::ParseFromUrlencoded() {
-    if (body_.empty()) {
-        return;
-    }
-
-    std::string key, value;
-    int num = 0;
-    int n = body_.size();
-    int i = 0, j = 0;
-
-    for (; i < n; ++i) {
-        char ch = body_[i];
-        switch (ch) {
-            case '=':
-                key = body_.substr(j, i - j);
-                j = i + 1;
-                break;
-            case '+':
-                body_[i] = ' ';
-                break;
-            case '%':
-                num = ConvertHexToDecimal(body_[i + 1]) * 16 +
-                      ConvertHexToDecimal(body_[i + 2]);
-                body_[i + 2] = num % 10 + '0';
-                body_[i + 1] = num / 10 + '0';
-                i += 2;
-                break;
-            case '&':
-                value = body_.substr(j, i - j);
-                j = i + 1;
-                post_request_parms_[key] = value;
-                spdlog::debug("{} = {}", key, value);
-                break;
-            default:
+// 把读缓冲区中已经到达的请求体交给接收者
+HttpRequest::ParseResult HttpRequest::ParseBody(Buffer& buff) {
+    while (true) {
+        if (!is_chunked_ || chunk_state_ == ChunkState::DATA) {
+            size_t len = std::min(body_left_, buff.ReadableBytes());
+            if (!ConsumeBody(buff, len)) {
+                return Fail();
+            }
+            body_left_ -= len;
+            if (body_left_ > 0) {
+                return ParseResult::INCOMPLETE;
+            }
+            if (!is_chunked_) {
                 break;
+            }
+            chunk_state_ = ChunkState::DATA_END;
+            continue;
+        }
+        // 其余部分都是一行，通常在读缓冲区的第一个块中，跨越多个块时才复制出来
+        size_t line_len = 0;
+        size_t first_len = 0;
+        bool found = false;
+        buff.ForEachChunk([&](const char* data, size_t len) {
+            if (found) {
+                return;
+            }
+            if (first_len == 0) {
+                first_len = len;
+            }
+            const char* eol = static_cast<const char*>(memchr(data, '\n', len));
+            found = eol != nullptr;
+            line_len += found ? eol - data : len;
+        });
+        if (!found) {
+            if (line_len > kMaxChunkLine_) {
+                spdlog::error("Chunk line too long!");
+                return Fail();
+            }
+            return ParseResult::INCOMPLETE;
+        }
+        std::string_view line(buff.ReadBegin(), line_len);
+        if (line_len >= first_len) {
+            line_.clear();
+            buff.ForEachChunk([&](const char* data, size_t len) {
+                line_.append(data, std::min(len, line_len - line_.size()));
+            });
+            line = line_;
+        }
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        bool done = false;
+        if (!ParseChunkLine(line, &done)) {
+            spdlog::error("Chunk Error! {}", line);
+            return Fail();
+        }
+        if (chunk_state_ == ChunkState::DATA) {
+            body_total_ += body_left_;
+            if (kMaxBodySize_ > 0 && body_total_ > kMaxBodySize_) {
+                return Fail(413);
+            }
+        }
+        buff.Retrieve(line_len + 1);
+        if (done) {
+            break;
         }
     }
-    // 获取最后一个请求参数
-    if (post_request_parms_.count(key) == 0 && j < i) {
-        value = body_.substr(j, i - j);
-        post_request_parms_[key] = value;
-    }
+    FinishParse();
+    SPDLOG_DEBUG("[{}], [{}], [{}], body: {} bytes", method(), url_, version(),
+                 body_store_.size());
+    return ParseResult::COMPLETE;
 }
 
-// 用户注册、登录校验
-bool HttpRequest::UserVerify(const std::string& name,
-                             const std::string& pwd,
-                             bool is_login) {
-    if (name == "" || pwd == "") {
-        return false;
+// 分块传输中的一行：块大小（十六进制，忽略 ';' 之后的扩展）、块数据之后的空行或者 trailer
+// 最后一个块（大小为 0）的 trailer 结束时 done 为 true；trailer 中的字段被忽略
+bool HttpRequest::ParseChunkLine(std::string_view line, bool* done) {
+    switch (chunk_state_) {
+        case ChunkState::SIZE: {
+            auto hex = [](char ch) -> int {
+                if (ch >= '0' && ch <= '9') {
+                    return ch - '0';
+                }
+                if (ch >= 'a' && ch <= 'f') {
+                    return ch - 'a' + 10;
+                }
+                if (ch >= 'A' && ch <= 'F') {
+                    return ch - 'A' + 10;
+                }
+                return -1;
+            };
+            size_t size = 0;
+            size_t i = 0;
+            for (; i < line.size(); ++i) {
+                int digit = hex(line[i]);
+                if (digit < 0) {
+                    break;
+                }
+                if (size > (SIZE_MAX >> 4)) {
+                    return false;
+                }
+                size = size << 4 | digit;
+            }
+            if (i == 0 || (i < line.size() && line[i] != ';' && line[i] != ' ' &&
+                           line[i] != '\t')) {
+                return false;
+            }
+            body_left_ = size;
+            chunk_state_ = size > 0 ? ChunkState::DATA : ChunkState::TRAILER;
+            return true;
+        }
+        case ChunkState::DATA_END:
+            chunk_state_ = ChunkState::SIZE;
+            return line.empty();
+        case ChunkState::TRAILER:
+            *done = line.empty();
+            return true;
+        default:
+            return false;
     }
-    spdlog::debug("Verify name: {},  pwd: {}", name, pwd);
-    MYSQL* sql;
-    SqlConnGuard sql_conn_guard(&sql, SqlConnPool::Instance());
-    assert(sql);
+}
 
-    bool flag = false;
-    char order[256]{};  // 存放 SQL 语句
-    MYSQL_RES* res{};
+// 把读缓冲区开头的 len 字节请求体依次交给处理函数（如果有）和 BodyStore，之后取走
+bool HttpRequest::ConsumeBody(Buffer& buff, size_t len) {
+    bool ok = true;
+    size_t left = len;
+    buff.ForEachChunk([&](const char* data, size_t n) {
+        n = std::min(n, left);
+        if (ok && n > 0) {
+            ok = (!body_handler_ || body_handler_(data, n)) &&
+                 body_store_.Append(data, n);
+            left -= n;
+        }
+    });
+    buff.Retrieve(len);
+    return ok;
+}
 
-    if (!is_login) {
-        flag = true;
+// 请求报文完整了，处理请求体并确定连接选项
+// HTTP/1.1 默认保持连接，除非带有 Connection: close；HTTP/1.0 须带有 Connection: keep-alive
+void HttpRequest::FinishParse() {
+    state_ = ParseState::FINISH;
+    if (HasConnectionOption("close")) {
+        is_keep_alive_ = false;
+    } else if (version() == "1.1") {
+        is_keep_alive_ = true;
+    } else {
+        is_keep_alive_ = version() == "1.0" && HasConnectionOption("keep-alive");
     }
-    // 查询用户及密码
-    snprintf(order, 256,
-             "SELECT username, password FROM user WHERE username='%s' LIMIT 1",
-             name.c_str());
-    spdlog::debug("sql: {}", order);
-
-    if (mysql_query(sql, order) != 0) {
-        mysql_free_result(res);
-        return false;
+    if (!body().empty()) {
+        ParsePost();
+        SPDLOG_DEBUG("Body:{}, len:{}", body(), body().size());
     }
+}
 
-    res = mysql_store_result(sql);
-    mysql_num_fields(res);
-
-    MYSQL_FIELD* fields{};
-    fields = mysql_fetch_fields(res);
+std::string_view HttpRequest::View(Field field) const {
+    if (!buff_) {
+        return {};
+    }
+    const char* base = head_.empty() ? buff_->ReadBegin() : head_.data();
+    return std::string_view(base + field.off, field.len);
+}
 
-    while (MYSQL_ROW row = mysql_fetch_row(res)) {
-        spdlog::debug("MYSQL ROW: {}, {}", row[0], row[1]);
-        std::string password(row[1]);
+HttpRequest::Field HttpRequest::ToField(const char* begin,
+                                        const char* end) const {
+    assert(buff_ && begin >= buff_->ReadBegin() && end >= begin);
+    return {static_cast<uint32_t>(begin - buff_->ReadBegin()),
+            static_cast<uint32_t>(end - begin)};
+}
 
-        // 登录 - 验证密码
-        if (is_login) {
-            if (pwd == password) {
-                flag = true;
-            } else {
-                flag = false;
-                spdlog::debug("pwd error!");
+// 解析 Post 请求
+void HttpRequest::ParsePost() {
+    if (method() == "POST" &&
+        GetHeader("Content-Type") == "application/x-www-form-urlencoded") {
+        // 将请求体解析成 Post 请求参数
+        ParseFromUrlencoded();
+        // 处理登录注册请求
+        if (kDefaultHtmlTag_.count(url_)) {
+            int tag = kDefaultHtmlTag_.at(url_);
+            SPDLOG_DEBUG("Tag:{}", tag);
+            if (tag == 0 || tag == 1) {
+                is_login_ = (tag == 1);
+                // 用户名、密码不为空时先查 UserCache，未命中再交给 UserVerifyTask 异步验证，
+                // 验证完成前不组装响应
+                const std::string& name = post_request_parms_["username"];
+                const std::string& pwd = post_request_parms_["password"];
+                if (name.empty() || pwd.empty()) {
+                    url_ = "/error.html";
+                    return;
+                }
+                switch (UserCache::Instance()->Verify(name, pwd, is_login_)) {
+                    case UserCache::Result::PASS:
+                        url_ = "/welcome.html";
+                        break;
+                    case UserCache::Result::FAIL:
+                        url_ = "/error.html";
+                        break;
+                    case UserCache::Result::MISS:
+                        needs_verify_ = true;
+                        break;
+                }
             }
         }
-        // 注册 - 用户名已存在
-        else {
-            flag = false;
-            spdlog::debug("user used!");
-        }
     }
-    mysql_free_result(res);
+}
 
-    // 注册行为 且 用户名未被使用
-    if (!is_login && flag == true) {
-        spdlog::debug("register!");
-        memset(order, 0, sizeof(order));
-        snprintf(order, 256,
-                 "INSERT INTO user(username, password) VALUES('%s','%s')",
-                 name.c_str(), pwd.c_str());
-        spdlog::debug("sql: {}", order);
-        if (mysql_query(sql, order) != 0) {
-            spdlog::debug("Insert error!");
-            flag = false;
+// 从 ContentType = application/x-www-form-urlencoded 的请求体中解析请求参数
+// 参数以 '&' 分隔，键、值分别解码（%XX 与 '+'），同名的参数以最后一个为准
+void HttpRequest::ParseFromUrlencoded() {
+    std::string_view data = body();
+    const char* p = data.data();
+    const char* end = p + data.size();
+    std::string key, value;
+    while (p < end) {
+        const char* amp = ByteScan::FindFirstOf(p, end, "&");
+        const char* eq = ByteScan::FindFirstOf(p, amp, "=");
+        if (eq != p) {
+            ByteScan::PercentDecode(std::string_view(p, eq - p), &key, true);
+            std::string_view raw_value =
+                eq < amp ? std::string_view(eq + 1, amp - eq - 1) : std::string_view();
+            ByteScan::PercentDecode(raw_value, &value, true);
+            SPDLOG_DEBUG("{} = {}", key, value);
+            post_request_parms_[key] = value;
         }
-        flag = true;
+        p = amp < end ? amp + 1 : end;
     }
-    spdlog::debug("UserVerify success!!");
-    return flag;
 }
@@ -3,34 +3,18 @@
 
 #include "http/httpresponse.h"
 
-const std::unordered_map<std::string, std::string> HttpResponse::kSuffixTypes_ =
-    {
-        {".html", "text/html"},
-        {".xml", "text/xml"},
-        {".xhtml", "application/xhtml+xml"},
-        {".txt", "text/plain"},
-        {".rtf", "application/rtf"},
-        {".pdf", "application/pdf"},
-        {".word", "application/nsword"},
-        {".png", "image/png"},
-        {".gif", "image/gif"},
-        {".jpg", "image/jpeg"},
-        {".jpeg", "image/jpeg"},
-        {".au", "audio/basic"},
-        {".mpeg", "video/mpeg"},
-        {".mpg", "video/mpeg"},
-        {".avi", "video/x-msvideo"},
-        {".gz", "application/x-gzip"},
-        {".tar", "application/x-tar"},
-        {".css", "text/css "},
-        {".js", "text/javascript "},
-};
-
 const std::unordered_map<int, std::string> HttpResponse::kStatusCodePhrases_ = {
-    {200, "OK"},           // 请求成功
-    {400, "Bad Request"},  // 客户发来的请求报文格式不合法
-    {403, "Forbidden"},    // 客户对所请求资源没有访问权限
-    {404, "Not Found"},    // 客户所请求的资源不存在
+    {200, "OK"},                     // 请求成功
+    {206, "Partial Content"},        // 只发送了文件的一部分（Range 请求）
+    {304, "Not Modified"},           // 客户缓存的版本仍然有效（条件 GET），没有响应体
+    {400, "Bad Request"},            // 客户发来的请求报文格式不合法
+    {403, "Forbidden"},              // 客户对所请求资源没有访问权限
+    {404, "Not Found"},              // 客户所请求的资源不存在
+    {408, "Request Timeout"},        // 没有在限定的时间内收完请求报文
+    {413, "Content Too Large"},      // 请求体超过了长度限制
+    {414, "URI Too Long"},           // 请求行超过了长度限制
+    {416, "Range Not Satisfiable"},  // Range 中的区间都超出了文件的范围
+    {431, "Request Header Fields Too Large"},  // 请求头的个数或总长度超过了限制
 };
 
 const std::unordered_map<int, std::string>
@@ -40,72 +24,269 @@ const std::unordered_map<int, std::string>
         {404, "/404.html"},
 };
 
+std::string HttpResponse::kMetricsPath_;
+int HttpResponse::kKeepAliveTimeout_ = 0;
+
 HttpResponse::HttpResponse() {
     code_ = -1;
     is_keep_alive_ = false;
+    keep_alive_left_ = 0;
     file_path_ = work_dir_ = "";
-    file_addr_ = nullptr;
-    file_stat_ = {};
+    content_encoding_ = nullptr;
+    vary_encoding_ = false;
 }
 
 HttpResponse::~HttpResponse() {
-    UnmapFile();
+    ReleaseFile();
 }
 
 void HttpResponse::Init(const std::string& work_dir,
                         std::string& file_path,
                         bool is_keep_alive,
-                        int code) {
+                        int code,
+                        int keep_alive_left) {
     assert(work_dir != "");
-    UnmapFile();
+    ReleaseFile();
     code_ = code;
     is_keep_alive_ = is_keep_alive;
+    keep_alive_left_ = keep_alive_left;
     file_path_ = file_path;
     work_dir_ = work_dir;
-    file_addr_ = nullptr;
-    file_stat_ = {};
+    content_encoding_ = nullptr;
+    vary_encoding_ = false;
+    etag_.clear();
+    ranges_.clear();
+    part_heads_.clear();
 }
 
-void HttpResponse::MakeResponse(Buffer& buff) {
-    // 考察所请求的资源文件的状态
-    if (stat((work_dir_ + file_path_).c_str(),&file_stat_) < 0 ||
-        S_ISDIR(file_stat_.st_mode)) {
-        code_ = 404;  // 不存在，或者是一个目录
-    } else if (!(file_stat_.st_mode & S_IROTH)) {
-        code_ = 403;  // 不可读
-    } else if (code_ == -1) {
-        code_ = 200;
+void HttpResponse::MakeResponse(Buffer& buff, const HttpRequest& request) {
+    // 考察所请求的资源文件的状态（由 FileCache 缓存，通常不需要系统调用）
+    // 指标页面由 Metrics 生成，不对应工作目录中的文件
+    // 请求报文有误（或超出限制）时 url 不可信，不查找所请求的文件，直接使用错误页面
+    if (code_ < 400) {
+        if (!kMetricsPath_.empty() && file_path_ == kMetricsPath_) {
+            file_ = MakeMetricsPage();
+        } else {
+            int64_t start = Metrics::Now();
+            file_ = FileCache::Instance()->Get(work_dir_ + file_path_);
+            Metrics::Observe(Histogram::FILE_LOOKUP, Metrics::Now() - start);
+        }
+        if (!file_->exists || S_ISDIR(file_->st.st_mode)) {
+            code_ = 404;  // 不存在，或者是一个目录
+        } else if (!(file_->st.st_mode & S_IROTH) ||
+                   (file_size() > 0 && !file_->addr && file_->fd < 0)) {
+            code_ = 403;  // 不可读
+        } else if (code_ == -1) {
+            code_ = 200;
+        }
     }
     HandleErrorStatusCode();
+    file_type_ = file_->type;
+    // 生成的内容（指标页面）没有校验器，不支持 Range、压缩和条件 GET
+    if (code_ == 200 && !file_->etag.empty()) {
+        // Range 只对 GET 有效（RFC 9110 §14.2），登录、注册的结果页面总是完整发送
+        // Range 作用于原始文件，因此只有不发送部分内容时才考虑压缩
+        if (request.method() == "GET") {
+            HandleRange(request);
+        }
+        // 无论是否压缩、是否为部分内容，可压缩的文件都带上 Vary，以免缓存混用不同编码的版本
+        vary_encoding_ = FileCache::IsCompressible(file_type_);
+        if (code_ == 200) {
+            NegotiateEncoding(request);
+        }
+        // 条件 GET 先于 Range 生效：客户缓存的版本仍然有效时只发送响应头
+        etag_ = file_->etag;
+        if (content_encoding_) {
+            etag_.insert(etag_.size() - 1, std::string("-") + content_encoding_);
+        }
+        if (request.IsNotModified(etag_, file_->st.st_mtime)) {
+            code_ = 304;
+            ranges_.clear();
+            part_heads_.clear();
+        }
+    }
     AddStartLine(buff);
     AddHeaders(buff);
     AddBody(buff);
 }
 
-void* HttpResponse::file_addr() const {
-    return file_addr_;
+size_t HttpResponse::file_size() const {
+    return file_ && file_->exists ? file_->st.st_size : 0;
 }
 
-size_t HttpResponse::file_size() const {
-    return file_stat_.st_size;
+// 响应体的长度：304、416 没有响应体，206 为各个区间（以及多区间响应中的分隔行）的长度之和
+size_t HttpResponse::body_size() const {
+    if (code_ == 304 || code_ == 416) {
+        return 0;
+    }
+    if (code_ != 206) {
+        return file_size();
+    }
+    size_t size = 0;
+    for (const auto& [offset, len] : ranges_) {
+        size += len;
+    }
+    for (const std::string& head : part_heads_) {
+        size += head.size();
+    }
+    return size;
 }
 
-std::string HttpResponse::file_type() const {
-    // 根据文件名后缀推断文件类型
-    auto idx = file_path_.find_last_of('.');
-    if (idx != std::string::npos) {
-        std::string suffix = file_path_.substr(idx);
-        if (kSuffixTypes_.count(suffix)) {
-            return kSuffixTypes_.at(suffix);
+// 将响应体按顺序追加到 segments 中（不拷贝数据，数据在响应释放前一直有效）
+void HttpResponse::AppendBody(std::vector<BodySegment>* segments) const {
+    assert(segments);
+    if (code_ == 304 || code_ == 416) {
+        return;
+    }
+    if (code_ != 206) {
+        AppendFileWindow(0, file_size(), segments);
+        return;
+    }
+    for (size_t i = 0; i < ranges_.size(); ++i) {
+        if (!part_heads_.empty()) {
+            segments->push_back(
+                {part_heads_[i].data(), -1, 0, part_heads_[i].size()});
         }
+        AppendFileWindow(ranges_[i].first, ranges_[i].second, segments);
     }
-    return "text/plain";
+    if (!part_heads_.empty()) {
+        segments->push_back(
+            {part_heads_.back().data(), -1, 0, part_heads_.back().size()});
+    }
+}
+
+std::string HttpResponse::file_type() const {
+    return file_type_;
+}
+
+int HttpResponse::code() const {
+    return code_;
 }
 
 void HttpResponse::HandleErrorStatusCode() {
     if (kErrorStatusCodeHtmlPaths_.count(code_)) {
         file_path_ = kErrorStatusCodeHtmlPaths_.at(code_);
-        stat((work_dir_ + file_path_).c_str(), &file_stat_);
+        file_ = FileCache::Instance()->Get(work_dir_ + file_path_);
+    } else if (code_ >= 400) {
+        // 没有错误页面的状态码（413、414、431 等），响应体为空
+        static const std::shared_ptr<const CachedFile> kEmptyPage = [] {
+            std::shared_ptr<CachedFile> page = std::make_shared<CachedFile>();
+            page->exists = true;
+            page->st.st_mode = S_IFREG | S_IRUSR | S_IRGRP | S_IROTH;
+            page->type = "text/html";
+            return page;
+        }();
+        file_ = kEmptyPage;
+    }
+}
+
+// 按 Accept-Encoding 选择文件的压缩版本，依次尝试 br、gzip，都没有时发送原始文件
+void HttpResponse::NegotiateEncoding(const HttpRequest& request) {
+    static const std::pair<ContentEncoding, const char*> kEncodings[] = {
+        {ContentEncoding::BROTLI, "br"},
+        {ContentEncoding::GZIP, "gzip"},
+    };
+    if (!FileCache::IsCompressible(file_type_)) {
+        return;
+    }
+    for (const auto& [encoding, name] : kEncodings) {
+        if (!request.AcceptsEncoding(name)) {
+            continue;
+        }
+        std::shared_ptr<const CachedFile> file =
+            FileCache::Instance()->GetCompressed(work_dir_ + file_path_, file_,
+                                                 encoding);
+        if (file) {
+            file_ = file;
+            content_encoding_ = name;
+            return;
+        }
+    }
+}
+
+// 处理 Range 请求：区间可以满足时改为 206，都不能满足时改为 416
+// 没有 Range、Range 格式有误、区间过多或者 If-Range 不匹配时，仍然发送整个文件
+void HttpResponse::HandleRange(const HttpRequest& request) {
+    std::vector<HttpRequest::ByteRange> specs;
+    if (!request.GetRanges(&specs) || specs.size() > kMaxRanges_ ||
+        !IsIfRangeMatched(request)) {
+        return;
+    }
+    const int64_t size = file_size();
+    for (const HttpRequest::ByteRange& spec : specs) {
+        int64_t first, last;
+        if (spec.first < 0) {
+            // 最后 spec.last 个字节
+            if (spec.last == 0 || size == 0) {
+                continue;
+            }
+            first = std::max<int64_t>(size - spec.last, 0);
+            last = size - 1;
+        } else {
+            if (spec.first >= size) {
+                continue;
+            }
+            first = spec.first;
+            last = spec.last < 0 ? size - 1 : std::min(spec.last, size - 1);
+        }
+        ranges_.emplace_back(first, last - first + 1);
+    }
+    if (ranges_.empty()) {
+        code_ = 416;
+        return;
+    }
+    code_ = 206;
+    if (ranges_.size() == 1) {
+        return;
+    }
+    // 多个区间：multipart/byteranges，每个部分之前是分隔行和 Content-Type、Content-Range
+    static std::atomic<uint64_t> boundary_seq{0};
+    char boundary[32];
+    snprintf(boundary, sizeof(boundary), "%016llx",
+             static_cast<unsigned long long>(
+                 (static_cast<uint64_t>(file_->st.st_ino) << 20) ^
+                 (static_cast<uint64_t>(file_->st.st_mtime) << 8) ^
+                 boundary_seq.fetch_add(1, std::memory_order_relaxed)));
+    boundary_ = std::string("webserver-") + boundary;
+    for (size_t i = 0; i < ranges_.size(); ++i) {
+        const auto& [offset, len] = ranges_[i];
+        part_heads_.push_back((i == 0 ? "--" : "\r\n--") + boundary_ +
+                              "\r\nContent-Type: " + file_type_ +
+                              "\r\nContent-Range: bytes " +
+                              std::to_string(offset) + "-" +
+                              std::to_string(offset + len - 1) + "/" +
+                              std::to_string(size) + "\r\n\r\n");
+    }
+    part_heads_.push_back("\r\n--" + boundary_ + "--\r\n");
+}
+
+// If-Range 为空时总是匹配；为实体标签时须与原始文件的 ETag 强比较一致，
+// 为日期时须与文件的修改时间一致（精确到秒）
+bool HttpResponse::IsIfRangeMatched(const HttpRequest& request) const {
+    std::string_view if_range = request.GetHeader("If-Range");
+    if (if_range.empty()) {
+        return true;
+    }
+    if (if_range.front() == '"' || if_range.substr(0, 2) == "W/") {
+        return if_range == file_->etag;
+    }
+    time_t t;
+    return HttpRequest::ParseHttpDate(if_range, &t) &&
+           t == file_->st.st_mtime;
+}
+
+// 将文件中的一个区间追加到 segments 中：映射到内存中的文件为内存段，否则为文件段
+void HttpResponse::AppendFileWindow(off_t offset,
+                                    size_t len,
+                                    std::vector<BodySegment>* segments) const {
+    if (len == 0 || !file_) {
+        return;
+    }
+    if (file_->addr) {
+        segments->push_back(
+            {static_cast<const char*>(file_->addr) + offset, -1, 0, len});
+    } else if (file_->fd >= 0) {
+        segments->push_back({nullptr, file_->fd, offset, len});
     }
 }
 
@@ -124,28 +305,81 @@ void HttpResponse::AddHeaders(Buffer& buff) {
     buff.Append("Connection: ");
     if (is_keep_alive_) {
         buff.Append("keep-alive\r\n");
-        buff.Append("keep-alive: max=6, timeout=120\r\n");
+        // 告诉客户服务器实际执行的空闲超时、剩余的请求数，客户可以在服务器关闭连接之前主动换用新连接
+        std::string params;
+        if (kKeepAliveTimeout_ > 0) {
+            params = "timeout=" + std::to_string(kKeepAliveTimeout_);
+        }
+        if (keep_alive_left_ > 0) {
+            params += (params.empty() ? "max=" : ", max=") +
+                      std::to_string(keep_alive_left_);
+        }
+        if (!params.empty()) {
+            buff.Append("Keep-Alive: " + params + "\r\n");
+        }
     } else {
         buff.Append("close\r\n");
     }
-    buff.Append("Content-type: " + file_type() + "\r\n");
+    if (!part_heads_.empty()) {
+        buff.Append("Content-type: multipart/byteranges; boundary=" + boundary_ +
+                    "\r\n");
+    } else if (code_ != 304) {
+        buff.Append("Content-type: " + file_type() + "\r\n");
+    }
+    // 校验器，客户据此发送条件 GET
+    bool has_validator = !etag_.empty();
+    if (has_validator && (code_ == 200 || code_ == 206 || code_ == 304)) {
+        buff.Append("ETag: " + etag_ + "\r\n");
+        buff.Append("Last-Modified: " + file_->last_modified + "\r\n");
+    }
+    // 支持 Range 请求的响应都带上 Accept-Ranges
+    if (has_validator && (code_ == 200 || code_ == 206)) {
+        buff.Append("Accept-Ranges: bytes\r\n");
+    }
+    if (code_ == 206 && part_heads_.empty()) {
+        const auto& [offset, len] = ranges_.front();
+        buff.Append("Content-Range: bytes " + std::to_string(offset) + "-" +
+                    std::to_string(offset + len - 1) + "/" +
+                    std::to_string(file_size()) + "\r\n");
+    } else if (code_ == 416) {
+        buff.Append("Content-Range: bytes */" + std::to_string(file_size()) +
+                    "\r\n");
+    }
+    if (content_encoding_) {
+        buff.Append("Content-Encoding: " + std::string(content_encoding_) + "\r\n");
+    }
+    if (vary_encoding_) {
+        buff.Append("Vary: Accept-Encoding\r\n");
+    }
 }
 
-// 实际上并没有往 buff 中写入 body
-// 而是将文件映射到内存中，并将其地址记录到成员变量 file_addr_ 中
-// 同时，往 buff 中写入 Content-length 和 一个空行
+// 实际上并没有往 buff 中写入 body，响应体由 AppendBody 以数据段的形式交给 HttpConn 发送。
+// 文件由 FileCache 按大小选择发送方式：
+// - 小文件映射到内存中，与响应头一起 writev
+// - 大文件保持打开，由 sendfile 直接从页缓存发送，避免 mmap/munmap 带来的缺页和 TLB 刷新
+// 往 buff 中写入的只有 Content-length 和 一个空行
 void HttpResponse::AddBody(Buffer& buff) {
-    int fd = open((work_dir_ + file_path_).c_str(), O_RDONLY);
-    assert(fd >= 0);
-    file_addr_ = mmap(0, file_size(), PROT_READ, MAP_PRIVATE, fd, 0);
-    close(fd);
-    buff.Append("Content-length: " + std::to_string(file_size()) + "\r\n\r\n");
-}
-
-void HttpResponse::UnmapFile() {
-    if (!file_addr_) {
+    // 304 没有响应体，也不发送 Content-length（否则须与 200 响应中的一致）
+    if (code_ == 304) {
+        buff.Append("\r\n");
         return;
     }
-    munmap(file_addr_, file_size());
-    file_addr_ = nullptr;
+    buff.Append("Content-length: " + std::to_string(body_size()) + "\r\n\r\n");
+}
+
+// 每次请求都重新导出，内容存放在一个不进入 FileCache 的 CachedFile 中
+std::shared_ptr<const CachedFile> HttpResponse::MakeMetricsPage() {
+    std::shared_ptr<CachedFile> page = std::make_shared<CachedFile>();
+    page->content = Metrics::Instance()->Export();
+    page->exists = true;
+    page->st.st_mode = S_IFREG | S_IRUSR | S_IRGRP | S_IROTH;
+    page->st.st_size = page->content.size();
+    page->type = "text/plain; version=0.0.4; charset=utf-8";
+    page->addr = page->content.empty() ? nullptr : page->content.data();
+    return page;
+}
+
+// 释放对缓存文件的引用，文件被淘汰后由最后一个使用者关闭或解除映射
+void HttpResponse::ReleaseFile() {
+    file_.reset();
 }
@@ -0,0 +1,148 @@
+// Author: Cukoo
+// Date: 2026-10-18
+
+#include "http/usercache.h"
+
+#ifdef WITH_OPENSSL
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/rand.h>
+#endif
+
+UserCache* UserCache::Instance() {
+    static UserCache user_cache;
+    return &user_cache;
+}
+
+// 密钥只存在于内存中，摘要因此无法在进程之外被离线穷举
+UserCache::UserCache() {
+#ifdef WITH_OPENSSL
+    has_key_ = RAND_bytes(key_, sizeof(key_)) == 1;
+    if (!has_key_) {
+        spdlog::warn("UserCache: RAND_bytes failed, passwords will not be cached");
+    }
+#endif
+}
+
+void UserCache::Init(int capacity, int ttl_ms) {
+    assert(capacity >= 0 && ttl_ms >= 0);
+    shard_capacity_ = (capacity + kShardNum_ - 1) / kShardNum_;
+    ttl_ns_ = static_cast<int64_t>(ttl_ms) * 1000000;
+}
+
+UserCache::Result UserCache::Verify(const std::string& name,
+                                    const std::string& pwd,
+                                    bool is_login) {
+    if (shard_capacity_ == 0) {
+        return Result::MISS;
+    }
+    // 摘要在加锁之前计算
+    unsigned char digest[kDigestSize_];
+    bool has_digest = is_login && Digest(pwd, digest);
+
+    Result res = Result::MISS;
+    Shard& shard = GetShard(name);
+    {
+        std::lock_guard<std::mutex> locker(shard.mtx);
+        auto it = shard.index.find(name);
+        if (it != shard.index.end()) {
+            const Record& record = it->second->second;
+            if (record.expires_at <= Now()) {
+                shard.lru.erase(it->second);
+                shard.index.erase(it);
+            } else {
+                shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+                if (!record.exists) {
+                    // 注册不存在的用户名仍须写入数据库
+                    res = is_login ? Result::FAIL : Result::MISS;
+                } else if (!is_login) {
+                    res = Result::FAIL;
+                } else if (has_digest && record.has_digest) {
+#ifdef WITH_OPENSSL
+                    res = CRYPTO_memcmp(digest, record.digest, kDigestSize_) == 0
+                              ? Result::PASS
+                              : Result::FAIL;
+#endif
+                }
+            }
+        }
+    }
+    if (res == Result::MISS) {
+        ++misses_;
+    } else {
+        ++hits_;
+        SPDLOG_DEBUG("UserCache hit: {}", name);
+    }
+    return res;
+}
+
+void UserCache::PutUser(const std::string& name, std::string_view pwd) {
+    Record record;
+    record.exists = true;
+    record.has_digest = Digest(pwd, record.digest);
+    Put(name, record);
+}
+
+void UserCache::PutUnknown(const std::string& name) {
+    Put(name, Record());
+}
+
+uint64_t UserCache::hits() const {
+    return hits_.load(std::memory_order_relaxed);
+}
+
+uint64_t UserCache::misses() const {
+    return misses_.load(std::memory_order_relaxed);
+}
+
+UserCache::Shard& UserCache::GetShard(const std::string& name) {
+    return shards_[std::hash<std::string>()(name) % kShardNum_];
+}
+
+// 插入或覆盖缓存项，分片已满时淘汰最久未使用的缓存项
+void UserCache::Put(const std::string& name, const Record& record) {
+    if (shard_capacity_ == 0) {
+        return;
+    }
+    Record entry = record;
+    entry.expires_at = Now() + ttl_ns_;
+    Shard& shard = GetShard(name);
+    std::lock_guard<std::mutex> locker(shard.mtx);
+    auto it = shard.index.find(name);
+    if (it != shard.index.end()) {
+        it->second->second = entry;
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+        return;
+    }
+    shard.lru.emplace_front(name, entry);
+    shard.index[name] = shard.lru.begin();
+    if (shard.lru.size() > shard_capacity_) {
+        shard.index.erase(shard.lru.back().first);
+        shard.lru.pop_back();
+    }
+}
+
+// HMAC-SHA256(key_, pwd)，没有密钥时返回 false
+bool UserCache::Digest(std::string_view pwd, unsigned char* out) const {
+#ifdef WITH_OPENSSL
+    if (!has_key_) {
+        return false;
+    }
+    unsigned int len = 0;
+    return HMAC(EVP_sha256(), key_, sizeof(key_),
+                reinterpret_cast<const unsigned char*>(pwd.data()), pwd.size(),
+                out, &len) != nullptr &&
+           len == kDigestSize_;
+#else
+    (void)pwd;
+    (void)out;
+    return false;
+#endif
+}
+
+int64_t UserCache::Now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
@@ -0,0 +1,208 @@
+// Author: Cukoo
+// Date: 2026-10-18
+
+#include "http/userverify.h"
+
+UserVerifyTask::UserVerifyTask(uint64_t tag,
+                               const std::string& name,
+                               const std::string& pwd,
+                               bool is_login)
+    : tag_(tag),
+      name_(name),
+      pwd_(pwd),
+      is_login_(is_login),
+      conn_(nullptr),
+      step_(Step::SELECT),
+      is_waiting_(false),
+      ok_(false),
+      result_(false) {
+    SPDLOG_DEBUG("Verify name: {},  pwd: {}", name_, pwd_);
+}
+
+// 只在验证完成后销毁（或在关闭服务器时丢弃），此时连接上没有进行中的语句
+UserVerifyTask::~UserVerifyTask() {
+    ReleaseConn();
+}
+
+void UserVerifyTask::SetConn(SqlConn* conn) {
+    assert(conn && !conn_);
+    conn_ = conn;
+}
+
+// 阻塞地执行全部语句
+void UserVerifyTask::Run() {
+    assert(conn_);
+    while (step_ != Step::FINISH) {
+        SqlStatement* stmt = CurrentStmt();
+        if (step_ == Step::STORE_RESULT) {
+            ok_ = stmt->StoreResult();
+        } else {
+            BindParams(stmt);
+            ok_ = stmt->Execute();
+        }
+        NextStep();
+    }
+    // 在当前（专用）线程中归还，连接断开时的重连也就不会占用 Reactor 线程
+    ReleaseConn();
+}
+
+#ifdef WITH_MYSQL_NONBLOCKING
+// 推进验证：events 为 MySQL socket 上就绪的事件（第一次调用时为 0）
+// 每一步用 *Start 开始、*Cont 继续，返回非 0 时需要等待 socket 就绪
+// 返回需要等待的事件（EPOLLIN 等），0 表示验证已完成
+// 连接池没有设置读写超时，因此不会出现 MYSQL_WAIT_TIMEOUT
+uint32_t UserVerifyTask::Continue(uint32_t events) {
+    assert(conn_);
+    int ready = 0;
+    if (events & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+        ready |= MYSQL_WAIT_READ;
+    }
+    if (events & (EPOLLOUT | EPOLLERR | EPOLLHUP)) {
+        ready |= MYSQL_WAIT_WRITE;
+    }
+    if (events & EPOLLPRI) {
+        ready |= MYSQL_WAIT_EXCEPT;
+    }
+    while (step_ != Step::FINISH) {
+        SqlStatement* stmt = CurrentStmt();
+        int status;
+        if (step_ == Step::STORE_RESULT) {
+            status = is_waiting_ ? stmt->StoreResultCont(&ok_, ready)
+                                 : stmt->StoreResultStart(&ok_);
+        } else if (is_waiting_) {
+            status = stmt->ExecuteCont(&ok_, ready);
+        } else {
+            BindParams(stmt);
+            status = stmt->ExecuteStart(&ok_);
+        }
+        if (status != 0) {
+            is_waiting_ = true;
+            uint32_t wait = 0;
+            if (status & MYSQL_WAIT_READ) {
+                wait |= EPOLLIN;
+            }
+            if (status & MYSQL_WAIT_WRITE) {
+                wait |= EPOLLOUT;
+            }
+            if (status & MYSQL_WAIT_EXCEPT) {
+                wait |= EPOLLPRI;
+            }
+            return wait;
+        }
+        is_waiting_ = false;
+        NextStep();
+    }
+    return 0;
+}
+
+int UserVerifyTask::fd() const {
+    assert(conn_);
+    return mysql_get_socket(conn_->sql());
+}
+#else
+uint32_t UserVerifyTask::Continue(uint32_t events) {
+    (void)events;
+    Run();
+    return 0;
+}
+
+int UserVerifyTask::fd() const {
+    return -1;
+}
+#endif
+
+uint64_t UserVerifyTask::tag() const {
+    return tag_;
+}
+
+bool UserVerifyTask::result() const {
+    return result_;
+}
+
+SqlStatement* UserVerifyTask::CurrentStmt() const {
+    return conn_->stmt(step_ == Step::INSERT ? SqlConn::Stmt::INSERT_USER
+                                             : SqlConn::Stmt::SELECT_USER);
+}
+
+// 参数指向 name_、pwd_，在任务销毁前一直有效
+void UserVerifyTask::BindParams(SqlStatement* stmt) const {
+    stmt->Bind(0, name_);
+    if (step_ == Step::INSERT) {
+        stmt->Bind(1, pwd_);
+    }
+}
+
+// 上一步完成后决定下一步，语句失败时检查连接是否已断开
+void UserVerifyTask::NextStep() {
+    if (!ok_) {
+        conn_->CheckError(*CurrentStmt());
+    }
+    switch (step_) {
+        case Step::SELECT:
+            step_ = ok_ ? Step::STORE_RESULT : Step::FINISH;
+            break;
+        case Step::STORE_RESULT:
+            result_ = ok_ && CheckUser();
+            CurrentStmt()->FreeResult();
+            // 注册行为 且 用户名未被使用
+            if (!is_login_ && result_) {
+                SPDLOG_DEBUG("register!");
+                step_ = Step::INSERT;
+            } else {
+                step_ = Step::FINISH;
+            }
+            break;
+        case Step::INSERT:
+            if (!ok_) {
+                SPDLOG_DEBUG("Insert error!");
+            }
+            result_ = ok_;
+            // 写入缓存，新用户随后的登录不必再查询数据库
+            if (ok_) {
+                UserCache::Instance()->PutUser(name_, pwd_);
+            }
+            step_ = Step::FINISH;
+            break;
+        case Step::FINISH:
+            break;
+    }
+    if (step_ == Step::FINISH) {
+        SPDLOG_DEBUG("UserVerify {}", result_ ? "success!!" : "failed!");
+    }
+}
+
+// 登录时密码须一致，注册时用户名须未被使用，查询结果同时写入 UserCache
+bool UserVerifyTask::CheckUser() const {
+    SqlStatement* stmt = CurrentStmt();
+    bool flag = !is_login_;
+    bool found = false;
+    while (stmt->Fetch()) {
+        SPDLOG_DEBUG("MYSQL ROW: {}, {}", stmt->GetString(0),
+                     stmt->GetString(1));
+        found = true;
+        UserCache::Instance()->PutUser(name_, stmt->GetString(1));
+        // 登录 - 验证密码
+        if (is_login_) {
+            flag = pwd_ == stmt->GetString(1);
+            if (!flag) {
+                SPDLOG_DEBUG("pwd error!");
+            }
+        }
+        // 注册 - 用户名已存在
+        else {
+            flag = false;
+            SPDLOG_DEBUG("user used!");
+        }
+    }
+    if (!found) {
+        UserCache::Instance()->PutUnknown(name_);
+    }
+    return flag;
+}
+
+void UserVerifyTask::ReleaseConn() {
+    if (conn_) {
+        SqlConnPool::Instance()->ReturnConn(conn_);
+        conn_ = nullptr;
+    }
+}
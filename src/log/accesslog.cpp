@@ -0,0 +1,201 @@
+// Author: Cukoo
+// Date: 2026-10-18
+
+#include "log/accesslog.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <spdlog/spdlog.h>
+
+namespace {
+
+// 复制不超过 N 字节，不足时以 '\0' 结尾
+template <size_t N>
+void CopyField(char (&dst)[N], std::string_view src) {
+    size_t len = std::min(src.size(), N);
+    memcpy(dst, src.data(), len);
+    if (len < N) {
+        dst[len] = '\0';
+    }
+}
+
+}  // namespace
+
+AccessLog* AccessLog::Instance() {
+    static AccessLog log;
+    return &log;
+}
+
+AccessLog::~AccessLog() {
+    Close();
+}
+
+void AccessLog::Init(const char* path) {
+    if (!path || is_open_) {
+        return;
+    }
+    fd_ = open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        spdlog::error("Open access log {} failed: {}", path, strerror(errno));
+        return;
+    }
+    stop_ = false;
+    writer_ = std::thread(&AccessLog::Run, this);
+    is_open_ = true;
+}
+
+void AccessLog::Close() {
+    if (!is_open_.exchange(false)) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> locker(mtx_);
+        stop_ = true;
+    }
+    cond_.notify_one();
+    writer_.join();
+    close(fd_);
+    fd_ = -1;
+}
+
+uint64_t AccessLog::dropped() {
+    std::lock_guard<std::mutex> locker(mtx_);
+    uint64_t total = 0;
+    for (const auto& ring : rings_) {
+        total += ring->dropped.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+// 由所属线程调用：写入一条记录，满了就丢弃
+void AccessLog::Append(Ring& ring,
+                       const sockaddr_in& addr,
+                       std::string_view method,
+                       std::string_view url,
+                       std::string_view version,
+                       int code,
+                       size_t bytes) {
+    uint64_t tail = ring.tail.load(std::memory_order_relaxed);
+    if (tail - ring.cached_head >= kRingSize_) {
+        ring.cached_head = ring.head.load(std::memory_order_acquire);
+        if (tail - ring.cached_head >= kRingSize_) {
+            ring.dropped.store(ring.dropped.load(std::memory_order_relaxed) + 1,
+                               std::memory_order_relaxed);
+            return;
+        }
+    }
+    Record& record = ring.records[tail & (kRingSize_ - 1)];
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+    record.time = ts.tv_sec;
+    record.bytes = bytes;
+    record.ip = addr.sin_addr.s_addr;
+    record.code = code;
+    record.url_len = std::min(url.size(), kMaxUrlLen_);
+    memcpy(record.url, url.data(), record.url_len);
+    CopyField(record.method, method);
+    CopyField(record.version, version);
+    ring.tail.store(tail + 1, std::memory_order_release);
+}
+
+AccessLog::Ring* AccessLog::NewRing() {
+    std::lock_guard<std::mutex> locker(mtx_);
+    rings_.emplace_back(new Ring());
+    return rings_.back().get();
+}
+
+// 后台线程：每隔 kIntervalMs_ 取走一次所有的记录，停止前再取一次
+void AccessLog::Run() {
+    std::string out;
+    out.reserve(2 * kFlushBytes_);
+    std::unique_lock<std::mutex> locker(mtx_);
+    while (!stop_) {
+        locker.unlock();
+        Drain(&out);
+        Flush(&out);
+        locker.lock();
+        cond_.wait_for(locker, std::chrono::milliseconds(kIntervalMs_),
+                       [this]() { return stop_; });
+    }
+    locker.unlock();
+    Drain(&out);
+    Flush(&out);
+}
+
+// 格式化各个缓冲区中已有的记录
+void AccessLog::Drain(std::string* out) {
+    std::vector<Ring*> rings;
+    {
+        std::lock_guard<std::mutex> locker(mtx_);
+        for (const auto& ring : rings_) {
+            rings.push_back(ring.get());
+        }
+    }
+    for (Ring* ring : rings) {
+        uint64_t head = ring->head.load(std::memory_order_relaxed);
+        uint64_t tail = ring->tail.load(std::memory_order_acquire);
+        for (; head != tail; ++head) {
+            Format(ring->records[head & (kRingSize_ - 1)], out);
+            if (out->size() >= kFlushBytes_) {
+                // 先归还已格式化的空间，再做系统调用
+                ring->head.store(head + 1, std::memory_order_release);
+                Flush(out);
+            }
+        }
+        ring->head.store(tail, std::memory_order_release);
+    }
+}
+
+// 127.0.0.1 - - [18/Oct/2026:10:00:00 +0800] "GET /index.html HTTP/1.1" 200 3061
+void AccessLog::Format(const Record& record, std::string* out) {
+    if (record.time != last_time_) {
+        time_t t = record.time;
+        tm local;
+        localtime_r(&t, &local);
+        strftime(time_buf_, sizeof(time_buf_), "%d/%b/%Y:%H:%M:%S %z", &local);
+        last_time_ = record.time;
+    }
+    char ip[INET_ADDRSTRLEN];
+    in_addr addr{record.ip};
+    inet_ntop(AF_INET, &addr, ip, sizeof(ip));
+    int method_len = strnlen(record.method, sizeof(record.method));
+    int version_len = strnlen(record.version, sizeof(record.version));
+    char line[256];
+    int len;
+    // 请求行无法解析时没有方法，与 CLF 的惯例一致记为 "-"
+    if (method_len == 0) {
+        len = snprintf(line, sizeof(line), "%s - - [%s] \"-\" %u %lu\n", ip,
+                       time_buf_, record.code,
+                       static_cast<unsigned long>(record.bytes));
+    } else {
+        len = snprintf(line, sizeof(line),
+                       "%s - - [%s] \"%.*s %.*s HTTP/%.*s\" %u %lu\n", ip,
+                       time_buf_, method_len, record.method,
+                       static_cast<int>(record.url_len), record.url,
+                       version_len, record.version, record.code,
+                       static_cast<unsigned long>(record.bytes));
+    }
+    out->append(line, std::min<size_t>(len, sizeof(line) - 1));
+}
+
+// 写入格式化好的内容，写失败时丢弃
+void AccessLog::Flush(std::string* out) {
+    size_t written = 0;
+    while (written < out->size()) {
+        ssize_t len = write(fd_, out->data() + written, out->size() - written);
+        if (len < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            spdlog::error("Write access log failed: {}", strerror(errno));
+            break;
+        }
+        written += len;
+    }
+    out->clear();
+}
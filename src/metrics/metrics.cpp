@@ -0,0 +1,156 @@
+// Author: Cukoo
+// Date: 2026-10-18
+
+#include "metrics/metrics.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+
+constexpr const char* kPrefix = "webserver_";
+
+// 导出的直方图的桶上界为 2^kMinExp ~ 2^kMaxExp ns（约 128ns ~ 34s），解析等操作通常不到 1us
+constexpr int kMinExp = 7;
+constexpr int kMaxExp = 35;
+
+void AppendHeader(std::string* out,
+                  const std::string& name,
+                  const char* help,
+                  const char* type) {
+    *out += "# HELP " + name + " " + help + "\n";
+    *out += "# TYPE " + name + " " + type + "\n";
+}
+
+std::string FormatDouble(double value) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.9g", value);
+    return buf;
+}
+
+}  // namespace
+
+const char* const Metrics::kCounterNames_[] = {
+    "accepts",
+    "rejects",
+    "requests",
+    "bytes_written",
+    "timer_expirations",
+};
+
+const char* const Metrics::kCounterHelps_[] = {
+    "Accepted connections.",
+    "Connections rejected because the server is full.",
+    "Responses assembled.",
+    "Bytes written to clients.",
+    "Connections closed by the idle timer.",
+};
+
+const char* const Metrics::kHistogramNames_[] = {
+    "threadpool_wait",
+    "parse",
+    "file_lookup",
+    "sql_borrow_wait",
+};
+
+const char* const Metrics::kHistogramHelps_[] = {
+    "Time tasks spend queued in the thread pool.",
+    "Time spent in each HttpRequest::Parse call.",
+    "Time spent looking up (and loading) files in FileCache.",
+    "Time spent waiting for a pooled MySQL connection.",
+};
+
+Metrics* Metrics::Instance() {
+    static Metrics metrics;
+    return &metrics;
+}
+
+void Metrics::AddCallback(const std::string& name,
+                          const std::string& help,
+                          Type type,
+                          std::function<double()> callback) {
+    assert(callback);
+    std::lock_guard<std::mutex> locker(mtx_);
+    callbacks_.push_back({name, help, type, std::move(callback)});
+}
+
+void Metrics::ClearCallbacks() {
+    std::lock_guard<std::mutex> locker(mtx_);
+    callbacks_.clear();
+}
+
+// 累加各个线程的槽，生成 Prometheus 文本格式（version 0.0.4）
+// 读取与写入并发进行，结果不是严格的快照，但每个值都不会倒退
+std::string Metrics::Export() {
+    static_assert(sizeof(kCounterNames_) / sizeof(kCounterNames_[0]) ==
+                      static_cast<size_t>(Counter::COUNT),
+                  "every counter needs a name");
+    static_assert(sizeof(kHistogramNames_) / sizeof(kHistogramNames_[0]) ==
+                      static_cast<size_t>(Histogram::COUNT),
+                  "every histogram needs a name");
+    // 先取得本线程的槽：回调中记录指标时不会再在持有 mtx_ 时去分配槽
+    Local();
+    std::string out;
+    std::lock_guard<std::mutex> locker(mtx_);
+
+    for (int i = 0; i < static_cast<int>(Counter::COUNT); ++i) {
+        uint64_t total = 0;
+        for (const auto& slot : slots_) {
+            total += slot->counters[i].load(std::memory_order_relaxed);
+        }
+        std::string name = std::string(kPrefix) + kCounterNames_[i] + "_total";
+        AppendHeader(&out, name, kCounterHelps_[i], "counter");
+        out += name + " " + std::to_string(total) + "\n";
+    }
+
+    for (int i = 0; i < static_cast<int>(Histogram::COUNT); ++i) {
+        std::vector<uint64_t> buckets(kBucketNum_, 0);
+        uint64_t count = 0;
+        uint64_t sum = 0;
+        for (const auto& slot : slots_) {
+            const HistogramData& data = slot->histograms[i];
+            for (size_t j = 0; j < kBucketNum_; ++j) {
+                buckets[j] += data.buckets[j].load(std::memory_order_relaxed);
+            }
+            count += data.count.load(std::memory_order_relaxed);
+            sum += data.sum.load(std::memory_order_relaxed);
+        }
+        std::string name = std::string(kPrefix) + kHistogramNames_[i] + "_seconds";
+        AppendHeader(&out, name, kHistogramHelps_[i], "histogram");
+        // 桶的边界与 2 的幂对齐：样本按 value - 1 分桶，不大于 2^exp 的值都在 BucketIndex(2^exp) 之前的桶中
+        uint64_t cumulative = 0;
+        size_t j = 0;
+        for (int exp = kMinExp; exp <= kMaxExp; ++exp) {
+            size_t end = BucketIndex(1ull << exp);
+            for (; j < end; ++j) {
+                cumulative += buckets[j];
+            }
+            out += name + "_bucket{le=\"" +
+                   FormatDouble(static_cast<double>(1ull << exp) / 1e9) + "\"} " +
+                   std::to_string(cumulative) + "\n";
+        }
+        // 各个值分别读取，count 可能略小于桶中的总数，+Inf 桶取两者中较大的
+        for (; j < kBucketNum_; ++j) {
+            cumulative += buckets[j];
+        }
+        count = std::max(count, cumulative);
+        out += name + "_bucket{le=\"+Inf\"} " + std::to_string(count) + "\n";
+        out += name + "_sum " + FormatDouble(sum / 1e9) + "\n";
+        out += name + "_count " + std::to_string(count) + "\n";
+    }
+
+    for (const Callback& callback : callbacks_) {
+        std::string name = kPrefix + callback.name;
+        bool is_counter = callback.type == Type::COUNTER;
+        AppendHeader(&out, name, callback.help.c_str(),
+                     is_counter ? "counter" : "gauge");
+        out += name + " " + FormatDouble(callback.fn()) + "\n";
+    }
+    return out;
+}
+
+Metrics::ThreadSlot* Metrics::NewSlot() {
+    std::lock_guard<std::mutex> locker(mtx_);
+    slots_.emplace_back(new ThreadSlot());
+    return slots_.back().get();
+}
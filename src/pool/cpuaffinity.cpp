@@ -0,0 +1,80 @@
+// Author: Cukoo
+// Date: 2026-10-18
+
+#include "pool/cpuaffinity.h"
+
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <cstring>
+
+std::vector<int> CpuAffinity::Parse(const char* list) {
+    std::vector<int> cpus;
+    if (!list) {
+        return cpus;
+    }
+    const char* p = list;
+    while (*p) {
+        char* end;
+        long first = strtol(p, &end, 10);
+        if (end == p || first < 0) {
+            return {};
+        }
+        long last = first;
+        p = end;
+        if (*p == '-') {
+            last = strtol(p + 1, &end, 10);
+            if (end == p + 1 || last < first) {
+                return {};
+            }
+            p = end;
+        }
+        for (long cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(static_cast<int>(cpu));
+        }
+        if (*p == ',') {
+            ++p;
+        } else if (*p) {
+            return {};
+        }
+    }
+    return cpus;
+}
+
+bool CpuAffinity::Pin(int cpu) {
+    if (cpu < 0 || cpu >= CPU_SETSIZE) {
+        return false;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+// /sys/devices/system/cpu/cpuN/ 下有一个指向所在结点的 nodeK 链接
+int CpuAffinity::NodeOf(int cpu) {
+    char path[64];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu);
+    DIR* dir = opendir(path);
+    if (!dir) {
+        return -1;
+    }
+    int node = -1;
+    while (dirent* entry = readdir(dir)) {
+        if (strncmp(entry->d_name, "node", 4) == 0 &&
+            sscanf(entry->d_name + 4, "%d", &node) == 1) {
+            break;
+        }
+        node = -1;
+    }
+    closedir(dir);
+    return node;
+}
+
+int CpuAffinity::CpuCount() {
+    long n = sysconf(_SC_NPROCESSORS_CONF);
+    return n > 0 ? static_cast<int>(n) : 1;
+}
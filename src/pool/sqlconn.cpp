@@ -0,0 +1,275 @@
+// Author: Cukoo
+// Date: 2026-10-18
+
+#include "pool/sqlconn.h"
+
+#include <string.h>
+#include <algorithm>
+#include <charconv>
+
+namespace {
+
+// CR_* 客户端错误（2000 ~ 2999），如连接断开（CR_SERVER_LOST）、服务器已关闭（CR_SERVER_GONE_ERROR）
+constexpr unsigned int kMinClientError = 2000;
+constexpr unsigned int kMaxClientError = 2999;
+
+}  // namespace
+
+SqlStatement::SqlStatement(const char* query)
+    : query_(query), stmt_(nullptr) {
+    assert(query_);
+}
+
+SqlStatement::~SqlStatement() {
+    Close();
+}
+
+// 准备语句，并把结果列绑定到内部的缓冲区（重新准备时先关闭旧的语句）
+bool SqlStatement::Prepare(MYSQL* sql) {
+    assert(sql);
+    Close();
+    stmt_ = mysql_stmt_init(sql);
+    if (!stmt_) {
+        spdlog::error("MySQL statement init error!");
+        return false;
+    }
+    if (mysql_stmt_prepare(stmt_, query_, strlen(query_)) != 0) {
+        spdlog::error("MySQL prepare error: {}", mysql_stmt_error(stmt_));
+        Close();
+        return false;
+    }
+    size_t param_cnt = mysql_stmt_param_count(stmt_);
+    param_binds_.assign(param_cnt, MYSQL_BIND{});
+    params_.assign(param_cnt, Param{});
+
+    size_t column_cnt = mysql_stmt_field_count(stmt_);
+    result_binds_.assign(column_cnt, MYSQL_BIND{});
+    columns_.reset(new Column[column_cnt]);
+    for (size_t i = 0; i < column_cnt; ++i) {
+        MYSQL_BIND& bind = result_binds_[i];
+        bind.buffer_type = MYSQL_TYPE_STRING;
+        bind.buffer = columns_[i].data;
+        bind.buffer_length = kMaxColumnSize_;
+        bind.length = &columns_[i].length;
+        bind.is_null = &columns_[i].is_null;
+        bind.error = &columns_[i].error;
+    }
+    if (column_cnt > 0 && mysql_stmt_bind_result(stmt_, result_binds_.data())) {
+        spdlog::error("MySQL bind result error: {}", mysql_stmt_error(stmt_));
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void SqlStatement::Close() {
+    if (stmt_) {
+        mysql_stmt_close(stmt_);
+        stmt_ = nullptr;
+    }
+}
+
+void SqlStatement::Bind(size_t idx, std::string_view value) {
+    assert(idx < param_binds_.size());
+    MYSQL_BIND& bind = param_binds_[idx];
+    bind = MYSQL_BIND{};
+    bind.buffer_type = MYSQL_TYPE_STRING;
+    bind.buffer = const_cast<char*>(value.data());
+    bind.buffer_length = value.size();
+    params_[idx].length = value.size();
+    bind.length = &params_[idx].length;
+}
+
+void SqlStatement::Bind(size_t idx, int64_t value) {
+    assert(idx < param_binds_.size());
+    MYSQL_BIND& bind = param_binds_[idx];
+    bind = MYSQL_BIND{};
+    bind.buffer_type = MYSQL_TYPE_LONGLONG;
+    params_[idx].value = value;
+    bind.buffer = &params_[idx].value;
+}
+
+// 执行语句（语句未能准备好时直接失败）
+bool SqlStatement::Execute() {
+    return BindParams() && mysql_stmt_execute(stmt_) == 0;
+}
+
+// 把结果集全部取到客户端，之后 Fetch 不再需要网络 I/O
+bool SqlStatement::StoreResult() {
+    return stmt_ && mysql_stmt_store_result(stmt_) == 0;
+}
+
+#ifdef WITH_MYSQL_NONBLOCKING
+int SqlStatement::ExecuteStart(bool* ok) {
+    assert(ok);
+    int ret = 0;
+    if (!BindParams()) {
+        *ok = false;
+        return 0;
+    }
+    int status = mysql_stmt_execute_start(&ret, stmt_);
+    *ok = ret == 0;
+    return status;
+}
+
+int SqlStatement::ExecuteCont(bool* ok, int ready) {
+    assert(ok && stmt_);
+    int ret = 0;
+    int status = mysql_stmt_execute_cont(&ret, stmt_, ready);
+    *ok = ret == 0;
+    return status;
+}
+
+int SqlStatement::StoreResultStart(bool* ok) {
+    assert(ok && stmt_);
+    int ret = 0;
+    int status = mysql_stmt_store_result_start(&ret, stmt_);
+    *ok = ret == 0;
+    return status;
+}
+
+int SqlStatement::StoreResultCont(bool* ok, int ready) {
+    assert(ok && stmt_);
+    int ret = 0;
+    int status = mysql_stmt_store_result_cont(&ret, stmt_, ready);
+    *ok = ret == 0;
+    return status;
+}
+#endif
+
+// 取下一行到结果列的缓冲区中，没有更多的行（或出错）时返回 false
+bool SqlStatement::Fetch() {
+    if (!stmt_) {
+        return false;
+    }
+    int ret = mysql_stmt_fetch(stmt_);
+    return ret == 0 || ret == MYSQL_DATA_TRUNCATED;
+}
+
+void SqlStatement::FreeResult() {
+    if (stmt_) {
+        mysql_stmt_free_result(stmt_);
+    }
+}
+
+// 当前行第 col 列的值，NULL 为空串，在下一次 Fetch 之前有效
+std::string_view SqlStatement::GetString(size_t col) const {
+    assert(col < result_binds_.size());
+    const Column& column = columns_[col];
+    if (column.is_null) {
+        return {};
+    }
+    return {column.data, std::min<size_t>(column.length, kMaxColumnSize_)};
+}
+
+int64_t SqlStatement::GetInt(size_t col) const {
+    std::string_view value = GetString(col);
+    int64_t res = 0;
+    std::from_chars(value.data(), value.data() + value.size(), res);
+    return res;
+}
+
+// 语句未能准备好时视为 CR_UNKNOWN_ERROR
+unsigned int SqlStatement::error() const {
+    return stmt_ ? mysql_stmt_errno(stmt_) : kMinClientError;
+}
+
+// 每次执行前重新绑定参数：参数的地址可能已经变化
+bool SqlStatement::BindParams() {
+    if (!stmt_) {
+        return false;
+    }
+    return param_binds_.empty() ||
+           mysql_stmt_bind_param(stmt_, param_binds_.data()) == 0;
+}
+
+const char* const SqlConn::kStmtQueries_[] = {
+    "SELECT username, password FROM user WHERE username = ? LIMIT 1",
+    "INSERT INTO user(username, password) VALUES(?, ?)",
+};
+
+SqlConn::SqlConn(const char* host,
+                 int port,
+                 const char* user,
+                 const char* pwd,
+                 const char* db_name)
+    : host_(host),
+      port_(port),
+      user_(user),
+      pwd_(pwd),
+      db_name_(db_name),
+      sql_(nullptr),
+      is_broken_(true) {
+    static_assert(sizeof(kStmtQueries_) / sizeof(kStmtQueries_[0]) ==
+                      static_cast<size_t>(Stmt::COUNT),
+                  "every statement needs a query");
+}
+
+SqlConn::~SqlConn() {
+    Disconnect();
+}
+
+// 建立连接并准备所有语句，已有连接时先断开（即重新连接）
+bool SqlConn::Connect() {
+    Disconnect();
+    is_broken_ = true;
+    sql_ = mysql_init(nullptr);
+    if (!sql_) {
+        spdlog::error("MySQL init error!");
+        return false;
+    }
+#ifdef WITH_MYSQL_NONBLOCKING
+    // 启用 MariaDB 的非阻塞 API（mysql_stmt_execute_start 等），须在连接之前设置
+    mysql_options(sql_, MYSQL_OPT_NONBLOCK, 0);
+#endif
+    if (!mysql_real_connect(sql_, host_.c_str(), user_.c_str(), pwd_.c_str(),
+                            db_name_.c_str(), port_, nullptr, 0)) {
+        spdlog::error("MySQL connect error: {}", mysql_error(sql_));
+        return false;
+    }
+    for (int i = 0; i < static_cast<int>(Stmt::COUNT); ++i) {
+        if (!stmts_[i]) {
+            stmts_[i].reset(new SqlStatement(kStmtQueries_[i]));
+        }
+        if (!stmts_[i]->Prepare(sql_)) {
+            return false;
+        }
+    }
+    is_broken_ = false;
+    return true;
+}
+
+// 语句执行失败后调用：客户端错误说明连接已不可用，其上的语句也随之失效
+void SqlConn::CheckError(const SqlStatement& stmt) {
+    unsigned int err = stmt.error();
+    if (err >= kMinClientError && err <= kMaxClientError) {
+        spdlog::warn("MySQL connection broken: {}", err);
+        is_broken_ = true;
+    }
+}
+
+SqlStatement* SqlConn::stmt(Stmt which) {
+    assert(which != Stmt::COUNT);
+    return stmts_[static_cast<int>(which)].get();
+}
+
+MYSQL* SqlConn::sql() const {
+    return sql_;
+}
+
+bool SqlConn::IsBroken() const {
+    return is_broken_;
+}
+
+// 语句须在连接关闭之前关闭
+void SqlConn::Disconnect() {
+    for (auto& stmt : stmts_) {
+        if (stmt) {
+            stmt->Close();
+        }
+    }
+    if (sql_) {
+        mysql_close(sql_);
+        sql_ = nullptr;
+    }
+}
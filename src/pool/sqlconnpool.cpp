@@ -18,49 +18,102 @@ void SqlConnPool::Init(const char* host,
                        const char* db_name,
                        int size) {
     for (int i = 0; i < size; ++i) {
-        MYSQL* sql = nullptr;
-        sql = mysql_init(sql);
-        if (!sql) {
-            spdlog::error("MySQL init error!");
+        // 建立连接，并在其上准备好所有的预处理语句
+        std::unique_ptr<SqlConn> conn(
+            new SqlConn(host, port, user, pwd, db_name));
+        if (!conn->Connect()) {
             continue;
         }
-        sql = mysql_real_connect(sql, host, user, pwd, db_name, port, nullptr, 0);
-        if (!sql) {
-            spdlog::error("MySQL connect error!");
-            continue;
-        }
-        conns_que_.push(sql);
+        conns_que_.push(conn.get());
+        conns_.push_back(std::move(conn));
     }
+    if (conns_.empty()) {
+        spdlog::error("No MySQL connection available, login and register will fail.");
+    }
+#ifdef WITH_MYSQL_NONBLOCKING
+    // 查询由 Reactor 驱动，专用线程只负责断开后的重新连接
+    blocking_pool_.reset(new ThreadPool(1));
+#else
+    // 客户端库只有阻塞 API：查询在专用线程中执行，线程数与连接数相同，借到连接的查询无需排队
+    blocking_pool_.reset(new ThreadPool(size));
+#endif
 }
 
-MYSQL* SqlConnPool::BorrowConn() {
-    MYSQL* sql = nullptr;
+// 借用连接但不等待：有空闲连接时立即在当前线程中调用 callback，
+// 否则排队，之后由归还连接的线程调用。callback 不应阻塞
+// 连接池中一个连接都没有（Init 时全部连接失败）时永远等不到，立即以空指针调用 callback
+void SqlConnPool::BorrowConnAsync(ConnCallback callback) {
+    assert(callback);
     std::unique_lock<std::mutex> lck(mtx_);
-    while (conns_que_.empty()) {
-        cv_.wait(lck);
+    if (conns_.empty()) {
+        lck.unlock();
+        callback(nullptr);
+        return;
+    }
+    if (conns_que_.empty()) {
+        waiters_.push({std::move(callback), Metrics::Now()});
+        return;
     }
-    sql = conns_que_.front();
+    SqlConn* conn = conns_que_.front();
     conns_que_.pop();
     lck.unlock();
-    return sql;
+    Metrics::Observe(Histogram::SQL_BORROW_WAIT, 0);
+    callback(conn);
 }
 
-void SqlConnPool::ReturnConn(MYSQL* sql) {
-    assert(sql);
+// 连接已断开时交给专用线程重新连接，并重新准备所有语句，之后才放回连接池
+// 归还连接的可能是 Reactor 线程（非阻塞 API），阻塞的重连不能在这里进行
+void SqlConnPool::ReturnConn(SqlConn* conn) {
+    assert(conn);
+    if (conn->IsBroken() && blocking_pool_) {
+        blocking_pool_->AddTask([this, conn]() {
+            spdlog::warn("MySQL reconnecting...");
+            conn->Connect();
+            Release(conn);
+        });
+        return;
+    }
+    Release(conn);
+}
+
+// 把连接交给排队的异步借用者，或放回空闲队列
+void SqlConnPool::Release(SqlConn* conn) {
     std::unique_lock<std::mutex> lck(mtx_);
-    conns_que_.push(sql);
-    lck.unlock();
-    cv_.notify_one();
+    // 优先交给排队的异步借用者
+    if (!waiters_.empty()) {
+        Waiter waiter = std::move(waiters_.front());
+        waiters_.pop();
+        lck.unlock();
+        Metrics::Observe(Histogram::SQL_BORROW_WAIT,
+                         Metrics::Now() - waiter.since);
+        waiter.callback(conn);
+        return;
+    }
+    conns_que_.push(conn);
+}
+
+// 在专用线程中执行会阻塞的数据库操作（MySQL 客户端库不支持非阻塞 API 时使用）
+void SqlConnPool::RunBlocking(Task task) {
+    assert(blocking_pool_);
+    blocking_pool_->AddTask(std::move(task));
+}
+
+size_t SqlConnPool::FreeConnCount() {
+    std::lock_guard<std::mutex> lck(mtx_);
+    return conns_que_.size();
+}
+
+size_t SqlConnPool::WaiterCount() {
+    std::lock_guard<std::mutex> lck(mtx_);
+    return waiters_.size();
 }
 
 SqlConnPool::~SqlConnPool() {
+    blocking_pool_.reset();
     // 由于线程池先销毁，所有子线程都已经结束，说明外借的连接都已悉数归还
-    // 这样就保证了所有的连接都会被 close
+    // 这样就保证了所有的连接（及其上的语句）都会被 close
     std::unique_lock<std::mutex> lck(mtx_);
-    while (!conns_que_.empty()) {
-        auto conn = conns_que_.front();
-        conns_que_.pop();
-        mysql_close(conn);
-    }
+    conns_que_ = {};
+    conns_.clear();
     mysql_server_end();
 }
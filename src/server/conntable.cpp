@@ -0,0 +1,36 @@
+// Author: Cukoo
+// Date: 2026-10-18
+
+#include "server/conntable.h"
+
+ConnTable::ConnTable(int max_fd) : conns_(max_fd) {
+    assert(max_fd > 0);
+}
+
+// 获取 fd 对应的连接对象，必要时创建
+HttpConn* ConnTable::Get(int fd) {
+    assert(fd >= 0 && fd < max_fd());
+    if (!conns_[fd]) {
+        conns_[fd].reset(new HttpConn());
+    }
+    return conns_[fd].get();
+}
+
+// 根据事件数据（HttpConn::tag）查找连接
+// 连接已关闭，或者 fd 已被新连接复用（generation 不一致）时返回 nullptr
+HttpConn* ConnTable::Find(uint64_t tag) const {
+    int fd = static_cast<int>(tag & 0xffffffff);
+    uint32_t generation = static_cast<uint32_t>(tag >> 32);
+    if (fd < 0 || fd >= max_fd() || !conns_[fd]) {
+        return nullptr;
+    }
+    HttpConn* client = conns_[fd].get();
+    if (client->generation() != generation || client->IsClosed()) {
+        return nullptr;
+    }
+    return client;
+}
+
+int ConnTable::max_fd() const {
+    return static_cast<int>(conns_.size());
+}
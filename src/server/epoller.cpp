@@ -13,17 +13,25 @@ Epoller::~Epoller() {
 }
 
 bool Epoller::Add(int fd, uint32_t events) {
+    return Add(fd, events, static_cast<uint32_t>(fd));
+}
+
+bool Epoller::Add(int fd, uint32_t events, uint64_t data) {
     assert(fd >= 0);
     epoll_event ev{};
-    ev.data.fd = fd;
+    ev.data.u64 = data;
     ev.events = events;
     return 0 == epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev);
 }
 
 bool Epoller::Modify(int fd, uint32_t events) {
+    return Modify(fd, events, static_cast<uint32_t>(fd));
+}
+
+bool Epoller::Modify(int fd, uint32_t events, uint64_t data) {
     assert(fd >= 0);
     epoll_event ev{};
-    ev.data.fd = fd;
+    ev.data.u64 = data;
     ev.events = events;
     return 0 == epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &ev);
 }
@@ -39,8 +47,12 @@ int Epoller::Wait(int timeout) {
 }
 
 int Epoller::GetEventFd(size_t i) const {
+    return static_cast<int>(GetEventData(i) & 0xffffffff);
+}
+
+uint64_t Epoller::GetEventData(size_t i) const {
     assert(i < events_.size());
-    return events_[i].data.fd;
+    return events_[i].data.u64;
 }
 
 uint32_t Epoller::GetEvents(size_t i) const {
@@ -0,0 +1,469 @@
+// Author: Cukoo
+// Date: 2026-10-17
+
+#include "server/reactor.h"
+
+namespace {
+
+int OrDefault(int timeout, int fallback) {
+    return timeout > 0 ? timeout : fallback;
+}
+
+}  // namespace
+
+Reactor::Reactor(const Config& config,
+                 ConnTable* conns,
+                 ThreadPool* thread_pool,
+                 int max_event_num)
+    : kTimeout_(config.timeout),
+      kHeaderTimeout_(OrDefault(config.header_timeout, config.timeout)),
+      kBodyTimeout_(OrDefault(config.body_timeout, config.timeout)),
+      kWriteTimeout_(OrDefault(config.write_timeout, config.timeout)),
+      kMinTimeout_(std::min({kTimeout_, kHeaderTimeout_, kBodyTimeout_,
+                             kWriteTimeout_})),
+      is_closed_(false),
+      conn_count_(0),
+      thread_id_(std::thread::id()),
+      cpu_(-1),
+      listenfd_(-1),
+      wakeup_fd_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+      thread_pool_(thread_pool),
+      timer_wheel_(new TimerWheel(&Reactor::OnTimeout, this)),
+      epoller_(new Epoller(max_event_num)),
+      conns_(conns) {
+    assert(wakeup_fd_ >= 0 && conns_);
+    // 单 Reactor 模式下，工作线程处理完一次读写后再重新注册事件
+    // 多 Reactor 模式下，读写事件只注册一次，不再需要 epoll_ctl
+    if (thread_pool_) {
+        connfd_event_ = EPOLLONESHOT | EPOLLET | EPOLLRDHUP;
+    } else {
+        connfd_event_ = EPOLLIN | EPOLLOUT | EPOLLET | EPOLLRDHUP;
+    }
+    epoller_->Add(wakeup_fd_, EPOLLIN);
+}
+
+Reactor::~Reactor() {
+    for (auto& [fd, task] : verify_tasks_) {
+        delete task;
+    }
+    close(wakeup_fd_);
+}
+
+// 事件循环，在 Reactor 所属线程中运行
+void Reactor::Loop() {
+    thread_id_.store(std::this_thread::get_id(), std::memory_order_release);
+    // 之后由本线程首次创建的连接对象、缓冲区位于该 CPU 所在的 NUMA 结点上
+    if (cpu_ >= 0 && !CpuAffinity::Pin(cpu_)) {
+        spdlog::warn("Failed to pin reactor to CPU {}", cpu_);
+    }
+    int timeout = -1;
+    while (!is_closed_) {
+        if (kTimeout_ > 0) {
+            timeout = timer_wheel_->Tick();
+        }
+        // 有连接等着继续读时，只检查一下已就绪的事件，不阻塞
+        int event_cnt = epoller_->Wait(resume_reads_.empty() ? timeout : 0);
+        for (int i = 0; i < event_cnt; ++i) {
+            int fd = epoller_->GetEventFd(i);
+            uint32_t events = epoller_->GetEvents(i);
+            // 其他线程分发过来的新连接
+            if (fd == wakeup_fd_) {
+                HandleWakeup();
+                continue;
+            }
+            // 处理新客户的连接请求（仅单 Reactor 模式）
+            if (fd == listenfd_) {
+                on_accept_();
+                continue;
+            }
+            // 异步验证用户时等待的 MySQL socket
+            if (!verify_tasks_.empty()) {
+                auto it = verify_tasks_.find(fd);
+                if (it != verify_tasks_.end()) {
+                    ContinueVerify(it->second, events);
+                    continue;
+                }
+            }
+            // 事件数据即 HttpConn::tag，连接已关闭或 fd 已被复用时丢弃该事件
+            HttpConn* client = conns_->Find(epoller_->GetEventData(i));
+            if (!client) {
+                continue;
+            }
+            // 处理 connfd 上的错误
+            if (events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+                CloseConn(client);
+            }
+            // 处理 connfd 上的可读事件
+            else if (events & EPOLLIN) {
+                HandleReadableEvent(client);
+            }
+            // 处理 connfd 上的可写事件
+            else if (events & EPOLLOUT) {
+                HandleWritableEvent(client);
+            }
+            // 未定义事件
+            else {
+                spdlog::error("Unexpected event");
+            }
+        }
+        // 轮到上一轮用完读预算的连接继续读（它们可能已被关闭）
+        if (!resume_reads_.empty()) {
+            std::vector<uint64_t> tags;
+            tags.swap(resume_reads_);
+            for (uint64_t tag : tags) {
+                HttpConn* client = conns_->Find(tag);
+                if (client) {
+                    HandleReadableEvent(client);
+                }
+            }
+        }
+    }
+}
+
+void Reactor::Quit() {
+    is_closed_ = true;
+    Wakeup();
+}
+
+void Reactor::BindCpu(int cpu) {
+    cpu_ = cpu;
+}
+
+// 让 Reactor 同时负责监听 socket（单 Reactor 模式）
+void Reactor::SetAcceptor(int listenfd,
+                          uint32_t events,
+                          const std::function<void()>& on_accept) {
+    assert(listenfd >= 0 && on_accept);
+    listenfd_ = listenfd;
+    on_accept_ = on_accept;
+    bool ret = epoller_->Add(listenfd_, events);
+    assert(ret);
+    (void)ret;
+}
+
+// 将新连接交给该 Reactor，可以在任意线程中调用
+void Reactor::AddConn(int fd, const sockaddr_in& addr) {
+    assert(fd > 0);
+    ++conn_count_;
+    if (IsInLoopThread()) {
+        RegisterConn(fd, addr);
+        return;
+    }
+    std::unique_lock<std::mutex> lck(mtx_);
+    pending_conns_.emplace_back(fd, addr);
+    lck.unlock();
+    Wakeup();
+}
+
+// 在 Reactor 线程中执行 cb，可以在任意线程中调用
+void Reactor::QueueInLoop(std::function<void()> cb) {
+    std::unique_lock<std::mutex> lck(mtx_);
+    pending_tasks_.push_back(std::move(cb));
+    lck.unlock();
+    Wakeup();
+}
+
+int Reactor::conn_count() const {
+    return conn_count_;
+}
+
+int Reactor::cpu() const {
+    return cpu_;
+}
+
+bool Reactor::IsInLoopThread() const {
+    return thread_id_.load(std::memory_order_acquire) ==
+           std::this_thread::get_id();
+}
+
+void Reactor::Wakeup() {
+    uint64_t one = 1;
+    if (write(wakeup_fd_, &one, sizeof(one)) != sizeof(one)) {
+        spdlog::error("Reactor wakeup error!");
+    }
+}
+
+void Reactor::HandleWakeup() {
+    uint64_t cnt;
+    while (read(wakeup_fd_, &cnt, sizeof(cnt)) > 0) {
+    }
+    std::vector<std::pair<int, sockaddr_in>> conns;
+    std::vector<std::function<void()>> tasks;
+    std::unique_lock<std::mutex> lck(mtx_);
+    conns.swap(pending_conns_);
+    tasks.swap(pending_tasks_);
+    lck.unlock();
+    for (auto& [fd, addr] : conns) {
+        RegisterConn(fd, addr);
+    }
+    for (auto& task : tasks) {
+        task();
+    }
+}
+
+// 由 Reactor 线程执行：创建 HttpConn、定时器，并注册事件
+void Reactor::RegisterConn(int fd, const sockaddr_in& addr) {
+    HttpConn* client = conns_->Get(fd);
+    client->Init(fd, addr);
+    if (kTimeout_ > 0) {
+        // 定时器结点嵌入在 HttpConn 中，fd 被复用时结点可能仍在时间轮中，到期时按新连接的阶段重新检查
+        client->timer_node()->data = client;
+        ArmTimer(client);
+    }
+    if (thread_pool_) {
+        epoller_->Add(fd, EPOLLIN | connfd_event_, client->tag());
+    } else {
+        epoller_->Add(fd, connfd_event_, client->tag());
+    }
+    SPDLOG_DEBUG("Client[{}]({}:{}) enter. \t[client count:{}]",
+                 client->sockfd(), client->ip(), client->port(),
+                 HttpConn::client_count_);
+}
+
+void Reactor::HandleReadableEvent(HttpConn* client) {
+    assert(client);
+    // 等待验证期间不读（多 Reactor 模式下读事件常驻），否则流水线的客户可以让读缓冲区无限增长
+    // 边沿触发不会再通知，由 FinishVerify 安排验证完成后接着读
+    if (client->IsVerifying()) {
+        return;
+    }
+    ArmTimer(client);
+    if (thread_pool_) {
+        client->BeginTask();
+        thread_pool_->AddTask([this, client]() {
+            OnRead(client);
+            client->EndTask();
+        });
+    } else {
+        OnRead(client);
+    }
+}
+
+void Reactor::HandleWritableEvent(HttpConn* client) {
+    assert(client);
+    if (thread_pool_) {
+        ArmTimer(client);
+        client->BeginTask();
+        thread_pool_->AddTask([this, client]() {
+            OnWrite(client);
+            client->EndTask();
+        });
+    }
+    // 多 Reactor 模式下读写事件常驻，只在确有数据待写时才处理
+    else if (client->ToWriteBytes() > 0) {
+        ArmTimer(client);
+        OnWrite(client);
+    }
+}
+
+// 保证定时器至多在 kMinTimeout_ 之后到期，到期时再按连接所处的阶段检查是否真的超时
+// 定时器只会提前、不会延后：请求头的超时不因收到数据而重新计时，涓流发送的连接也会超时
+void Reactor::ArmTimer(HttpConn* client) {
+    assert(client);
+    if (kTimeout_ <= 0) {
+        return;
+    }
+    TimerNode* node = client->timer_node();
+    if (!node->IsLinked() ||
+        node->expires > TimerWheel::Now() + kMinTimeout_) {
+        timer_wheel_->Schedule(node, kMinTimeout_);
+    }
+}
+
+// 连接在当前阶段的超时时刻
+int64_t Reactor::Deadline(HttpConn* client) const {
+    int64_t since = client->phase_since();
+    switch (client->phase()) {
+        case HttpConn::Phase::CONNECTED:
+        case HttpConn::Phase::HEADERS:
+            return since + kHeaderTimeout_;
+        case HttpConn::Phase::BODY:
+            return std::max(since, client->last_read()) + kBodyTimeout_;
+        case HttpConn::Phase::WRITE:
+            return std::max(since, client->last_write()) + kWriteTimeout_;
+        default:
+            return since + kTimeout_;
+    }
+}
+
+// 时间轮的超时回调：连接尚未超时时按剩余的时间重新定时，否则关闭它（连接可能已被工作线程关闭）
+// 接收请求超时时先尽力发送 408 响应
+// 工作线程仍在处理该连接时（单 Reactor 模式）稍后再检查，关闭连接总是在工作线程返回之后
+void Reactor::OnTimeout(void* ctx, TimerNode* node) {
+    Reactor* reactor = static_cast<Reactor*>(ctx);
+    HttpConn* client = static_cast<HttpConn*>(node->data);
+    if (client->IsClosed()) {
+        return;
+    }
+    if (client->IsBusy()) {
+        reactor->timer_wheel_->Schedule(node, kBusyRecheck_);
+        return;
+    }
+    int64_t left = reactor->Deadline(client) - TimerWheel::Now();
+    if (left > 0) {
+        reactor->timer_wheel_->Schedule(node, static_cast<int>(left));
+        return;
+    }
+    Metrics::Add(Counter::TIMER_EXPIRATIONS);
+    HttpConn::Phase phase = client->phase();
+    if (phase == HttpConn::Phase::HEADERS || phase == HttpConn::Phase::BODY) {
+        client->SendRequestTimeout();
+    }
+    reactor->CloseConn(client);
+}
+
+void Reactor::CloseConn(HttpConn* client) {
+    assert(client);
+    // 连接可能已被关闭，其 fd 甚至已被新连接复用，此时不能再操作 epoll
+    if (client->IsClosed()) {
+        return;
+    }
+    epoller_->Remove(client->sockfd());
+    // 时间轮只能在 Reactor 线程中操作；工作线程关闭的连接，其定时器到期时什么也不做
+    if (kTimeout_ > 0 && IsInLoopThread()) {
+        timer_wheel_->Cancel(client->timer_node());
+    }
+    client->Close();
+    --conn_count_;
+}
+
+// 从 connfd 中读数据
+void Reactor::OnRead(HttpConn* client) {
+    assert(client);
+    int ret = -1;
+    int read_errno = 0;
+    ret = client->Read(&read_errno);
+    // 发生错误
+    if (ret == -1 && read_errno != EAGAIN) {
+        CloseConn(client);
+        return;
+    }
+    // 对方已关闭连接
+    if (ret == 0) {
+        CloseConn(client);
+        return;
+    }
+    // 处理（解析）刚刚读到的数据
+    OnProcess(client);
+}
+
+// 紧跟在 OnRead 之后执行
+// 处理实际包含两个部分工作：解析请求报文、生成响应报文内容（并将其填充到写缓冲区中）
+void Reactor::OnProcess(HttpConn* client) {
+    HttpConn::ProcessResult result = client->Process();
+    if (result == HttpConn::ProcessResult::WRITE) {
+        // 响应报文已经准备完毕，接下来就只要准备写了
+        if (thread_pool_) {
+            epoller_->Modify(client->sockfd(), connfd_event_ | EPOLLOUT,
+                            client->tag());
+        } else {
+            OnWrite(client);  // 直接尝试写，大多数响应可以一次写完
+        }
+    } else if (result == HttpConn::ProcessResult::READ) {
+        // 请求报文不完整，接下来还得继续读
+        // 单 Reactor 模式下重新注册的 EPOLLIN 在 socket 中还有数据时会立即触发；
+        // 多 Reactor 模式下（边沿触发）用完读预算的连接不会再有事件，由 Loop 在处理完其他事件后接着读
+        if (thread_pool_) {
+            epoller_->Modify(client->sockfd(), connfd_event_ | EPOLLIN,
+                            client->tag());
+        } else if (client->IsReadPaused()) {
+            resume_reads_.push_back(client->tag());
+        }
+    } else if (result == HttpConn::ProcessResult::VERIFY) {
+        // 挂起该连接（单 Reactor 模式下不再注册事件），验证完成后再继续处理
+        StartVerify(client);
+    }
+}
+
+// 异步地验证用户（登录、注册），等待期间不占用 Reactor 线程和工作线程
+// 借到数据库连接后，查询由 Reactor 线程驱动（非阻塞 API），或者在连接池的专用线程中执行，
+// 完成后回到 Reactor 线程继续处理该连接
+void Reactor::StartVerify(HttpConn* client) {
+    const HttpRequest& request = client->request();
+    UserVerifyTask* task = new UserVerifyTask(
+        client->tag(), request.GetPostRequestParm("username"),
+        request.GetPostRequestParm("password"), request.IsLogin());
+    SqlConnPool::Instance()->BorrowConnAsync([this, task](SqlConn* conn) {
+        // 没有可用的数据库连接，验证直接失败
+        if (!conn) {
+            QueueInLoop([this, task]() { FinishVerify(task); });
+            return;
+        }
+        task->SetConn(conn);
+#ifdef WITH_MYSQL_NONBLOCKING
+        QueueInLoop([this, task]() { ContinueVerify(task, 0); });
+#else
+        SqlConnPool::Instance()->RunBlocking([this, task]() {
+            task->Run();
+            QueueInLoop([this, task]() { FinishVerify(task); });
+        });
+#endif
+    });
+}
+
+// 由 Reactor 线程执行：推进查询，并按需要等待的事件注册 MySQL socket
+void Reactor::ContinueVerify(UserVerifyTask* task, uint32_t events) {
+    int fd = task->fd();
+    uint32_t wait = task->Continue(events);
+    bool is_watched = verify_tasks_.count(fd) > 0;
+    if (wait == 0) {
+        if (is_watched) {
+            epoller_->Remove(fd);
+            verify_tasks_.erase(fd);
+        }
+        FinishVerify(task);
+    } else if (is_watched) {
+        epoller_->Modify(fd, wait);
+    } else {
+        verify_tasks_[fd] = task;
+        epoller_->Add(fd, wait);
+    }
+}
+
+// 由 Reactor 线程执行：归还数据库连接，并继续处理等待验证结果的连接（连接可能已被关闭）
+void Reactor::FinishVerify(UserVerifyTask* task) {
+    HttpConn* client = conns_->Find(task->tag());
+    bool ok = task->result();
+    delete task;
+    if (!client) {
+        return;
+    }
+    if (thread_pool_) {
+        client->BeginTask();
+        thread_pool_->AddTask([this, client, ok]() {
+            client->FinishVerify(ok);
+            OnProcess(client);
+            client->EndTask();
+        });
+    } else {
+        client->FinishVerify(ok);
+        OnProcess(client);
+        // 验证期间 socket 中可能积压了数据
+        if (!client->IsClosed()) {
+            resume_reads_.push_back(client->tag());
+        }
+    }
+}
+
+// 往 connfd 中写数据
+void Reactor::OnWrite(HttpConn* client) {
+    assert(client);
+    int ret = -1;
+    int write_errno = 0;
+    ret = client->Write(&write_errno);
+    if (client->ToWriteBytes() == 0 && client->IsKeepAlive()) {
+        // 传输完成，但需要保持连接
+        OnProcess(client);
+        return;
+    }
+    if (ret == -1 && write_errno == EAGAIN) {
+        // 未传输完成，需要等下一次可写
+        if (thread_pool_) {
+            epoller_->Modify(client->sockfd(), connfd_event_ | EPOLLOUT,
+                            client->tag());
+        }
+        return;
+    }
+    // 非预期情况，关闭连接
+    CloseConn(client);
+}
@@ -5,28 +5,73 @@
 
 int WebServer::SetFdNonblock(int fd) {
     assert(fd > 0);
-    return fcntl(fd, F_SETFL, fcntl(fd, F_GETFD, 0) | O_NONBLOCK);
+    return fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
 }
 
 WebServer::WebServer(Config config)
     : kWorkDir_(config.work_dir),
       kPort_(config.port),
       kEnableLinger_(config.enable_linger),
-      kTimeout_(config.timeout) {
+      kTimeout_(config.timeout),
+      kDispatchPolicy_(config.dispatch_policy),
+      kMaxFd_(config.max_fd) {
     spdlog::set_level(config.log_level);
     HttpConn::kWorkDir_ = kWorkDir_;
+    HttpConn::kReadBudget_ = config.read_budget;
+    HttpConn::kKeepAliveMax_ = config.keep_alive_requests;
+    HttpResponse::kKeepAliveTimeout_ = config.timeout > 0 ? config.timeout / 1000 : 0;
+    HttpRequest::kMaxStartLine_ = config.max_start_line;
+    HttpRequest::kMaxHeaders_ = config.max_headers;
+    HttpRequest::kMaxHeaderBytes_ = config.max_header_bytes;
+    HttpRequest::kMaxBodySize_ = config.max_body_size;
+    BodyStore::kSpillThreshold_ = config.body_spill_threshold;
+    BodyStore::kSpillDir_ = config.body_spill_dir;
+    FileCache::Instance()->Init(config.file_cache_capacity,
+                                config.file_cache_revalidate,
+                                config.sendfile_threshold, config.compression);
+    UserCache::Instance()->Init(config.user_cache_capacity,
+                                config.user_cache_ttl);
+    if (config.compression == Compression::AT_STARTUP) {
+        FileCache::Instance()->Precompress(kWorkDir_);
+    }
     is_closed_ = false;
+    next_reactor_ = 0;
 
     // 初始化一系列资源
-    // 定时器容器、线程池、epoll 内核事件表、数据库连接池、监听 socket
-    timer_heap_.reset(new TimerHeap());
-    thread_pool_.reset(new ThreadPool(config.thread_pool_size));
-    epoller_.reset(new Epoller(20000));
+    // 连接表、Reactor（事件引擎、定时器容器）、线程池、数据库连接池、监听 socket
+    conns_.reset(new ConnTable(kMaxFd_));
+    std::vector<int> reactor_cpus = CpuAffinity::Parse(config.reactor_cpus);
+    if (config.reactor_cpus && reactor_cpus.empty()) {
+        spdlog::warn("Invalid reactor CPU list: {}", config.reactor_cpus);
+    }
+    if (config.reactor_num > 0) {
+        // 多 Reactor 模式：每个 Reactor 线程处理自己的连接，不再需要线程池
+        epoller_.reset(new Epoller());
+        for (int i = 0; i < config.reactor_num; ++i) {
+            reactors_.emplace_back(new Reactor(config, conns_.get()));
+        }
+    } else {
+        std::vector<int> worker_cpus = CpuAffinity::Parse(config.worker_cpus);
+        if (config.worker_cpus && worker_cpus.empty()) {
+            spdlog::warn("Invalid worker CPU list: {}", config.worker_cpus);
+        }
+        thread_pool_.reset(new ThreadPool(config.thread_pool_size, worker_cpus));
+        reactors_.emplace_back(
+            new Reactor(config, conns_.get(), thread_pool_.get(), 20000));
+    }
+    for (size_t i = 0; i < reactors_.size() && !reactor_cpus.empty(); ++i) {
+        reactors_[i]->BindCpu(reactor_cpus[i % reactor_cpus.size()]);
+    }
+    if (kDispatchPolicy_ == DispatchPolicy::INCOMING_CPU) {
+        BuildSteeringMap();
+    }
     SqlConnPool::Instance()->Init(config.host, config.sql_port, config.sql_user,
                                   config.sql_pwd, config.db_name,
                                   config.sql_conn_pool_size);
+    HttpResponse::kMetricsPath_ = config.metrics_path ? config.metrics_path : "";
+    AccessLog::Instance()->Init(config.access_log);
+    RegisterMetrics();
     listenfd_event_ = EPOLLET | EPOLLRDHUP;
-    connfd_event_ = EPOLLONESHOT | EPOLLET | EPOLLRDHUP;
     if (!InitListenSocket()) {
         is_closed_ = true;
     }
@@ -36,48 +81,50 @@ WebServer::WebServer(Config config)
                  kEnableLinger_ ? "true" : "false");
     spdlog::info("Work Directory: {}", kWorkDir_);
     spdlog::info("SQL Connection Pool Size: {}", config.sql_conn_pool_size);
-    spdlog::info("Thread Pool Size: {}", config.thread_pool_size);
+    if (thread_pool_) {
+        spdlog::info("Thread Pool Size: {}", config.thread_pool_size);
+    } else {
+        spdlog::info("Reactor Num: {}", config.reactor_num);
+    }
+    spdlog::info("Reactor CPUs: {}, Worker CPUs: {}",
+                 config.reactor_cpus ? config.reactor_cpus : "unbound",
+                 config.worker_cpus ? config.worker_cpus : "unbound");
 }
 
 WebServer::~WebServer() {
+    Metrics::Instance()->ClearCallbacks();
     close(listenfd_);
     is_closed_ = true;
+    for (auto& reactor : reactors_) {
+        reactor->Quit();
+    }
+    for (auto& t : reactor_threads_) {
+        t.join();
+    }
+    AccessLog::Instance()->Close();
+    spdlog::info("File cache hits: {}, misses: {}", FileCache::Instance()->hits(),
+                 FileCache::Instance()->misses());
+    spdlog::info("User cache hits: {}, misses: {}", UserCache::Instance()->hits(),
+                 UserCache::Instance()->misses());
+    spdlog::info("Access log records dropped: {}", AccessLog::Instance()->dropped());
 }
 
 void WebServer::Startup() {
-    int timeout = -1;
+    // 单 Reactor 模式：主线程运行唯一的 Reactor，同时负责监听 socket
+    if (thread_pool_) {
+        reactors_[0]->Loop();
+        return;
+    }
+    // 多 Reactor 模式：每个 Reactor 运行在独立的线程中，主线程只负责接收新连接
+    for (auto& reactor : reactors_) {
+        reactor_threads_.emplace_back(&Reactor::Loop, reactor.get());
+    }
     while (!is_closed_) {
-        if (kTimeout_ > 0) {
-            timeout = timer_heap_->Tick();
-        }
-        int event_cnt = epoller_->Wait(timeout);
+        int event_cnt = epoller_->Wait();
         for (int i = 0; i < event_cnt; ++i) {
-            // 处理事件
-            int fd = epoller_->GetEventFd(i);
-            uint32_t events = epoller_->GetEvents(i);
-            // 处理新客户的连接请求
-            if (fd == listenfd_) {
+            if (epoller_->GetEventFd(i) == listenfd_) {
                 HandleListenFdEvent();
             }
-            // 处理 connfd 上的错误
-            else if (events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
-                assert(clients_.count(fd));
-                CloseConn(&clients_[fd]);
-            }
-            // 处理 connfd 上的可读事件
-            else if (events & EPOLLIN) {
-                assert(clients_.count(fd));
-                HandleReadableEvent(&clients_[fd]);
-            }
-            // 处理 connfd 上的可写事件
-            else if (events & EPOLLOUT) {
-                assert(clients_.count(fd));
-                HandleWritableEvent(&clients_[fd]);
-            }
-            // 未定义事件
-            else {
-                spdlog::error("Unexpected event");
-            }
         }
     }
 }
@@ -116,8 +163,13 @@ bool WebServer::InitListenSocket() {
     assert(ret >= 0);
 
     // 注册事件
-    ret = epoller_->Add(listenfd_, listenfd_event_ | EPOLLIN);
-    assert(ret == 1);
+    if (thread_pool_) {
+        reactors_[0]->SetAcceptor(listenfd_, listenfd_event_ | EPOLLIN,
+                                  [this]() { HandleListenFdEvent(); });
+    } else {
+        ret = epoller_->Add(listenfd_, listenfd_event_ | EPOLLIN);
+        assert(ret == 1);
+    }
 
     SetFdNonblock(listenfd_);
     spdlog::info("Server port: {}", kPort_);
@@ -133,10 +185,48 @@ void WebServer::SendError(int fd, const char* message) {
     close(fd);
 }
 
-void WebServer::CloseConn(HttpConn* client) {
-    assert(client);
-    epoller_->Remove(client->sockfd());
-    client->Close();
+// 已经在别处维护的值，导出指标时才读取
+void WebServer::RegisterMetrics() {
+    Metrics* metrics = Metrics::Instance();
+    metrics->AddCallback("active_connections", "Open client connections.",
+                         Metrics::Type::GAUGE,
+                         []() { return HttpConn::client_count_.load(); });
+    if (thread_pool_) {
+        ThreadPool* pool = thread_pool_.get();
+        metrics->AddCallback("threadpool_queue_depth",
+                             "Tasks queued in the thread pool.",
+                             Metrics::Type::GAUGE,
+                             [pool]() { return pool->QueueSize(); });
+    }
+    metrics->AddCallback("sql_free_connections", "Idle pooled MySQL connections.",
+                         Metrics::Type::GAUGE, []() {
+                             return SqlConnPool::Instance()->FreeConnCount();
+                         });
+    metrics->AddCallback("sql_waiters",
+                         "Requests waiting for a pooled MySQL connection.",
+                         Metrics::Type::GAUGE, []() {
+                             return SqlConnPool::Instance()->WaiterCount();
+                         });
+    metrics->AddCallback("file_cache_hits_total", "FileCache hits.",
+                         Metrics::Type::COUNTER,
+                         []() { return FileCache::Instance()->hits(); });
+    metrics->AddCallback("file_cache_misses_total", "FileCache misses.",
+                         Metrics::Type::COUNTER,
+                         []() { return FileCache::Instance()->misses(); });
+    metrics->AddCallback("user_cache_hits_total", "UserCache hits.",
+                         Metrics::Type::COUNTER,
+                         []() { return UserCache::Instance()->hits(); });
+    metrics->AddCallback("user_cache_misses_total", "UserCache misses.",
+                         Metrics::Type::COUNTER,
+                         []() { return UserCache::Instance()->misses(); });
+    metrics->AddCallback("buffer_heap_bytes",
+                         "Heap memory held by connection buffer chunks, including cached free chunks.",
+                         Metrics::Type::GAUGE,
+                         []() { return ChunkPool::HeapBytes(); });
+    metrics->AddCallback("access_log_dropped_total",
+                         "Access log records dropped because a ring buffer was full.",
+                         Metrics::Type::COUNTER,
+                         []() { return AccessLog::Instance()->dropped(); });
 }
 
 void WebServer::HandleListenFdEvent() {
@@ -151,98 +241,68 @@ void WebServer::HandleListenFdEvent() {
             }
             return;
         }
-        if (HttpConn::client_count_ >= kMaxFd_) {
+        if (fd >= kMaxFd_ || HttpConn::client_count_ >= kMaxFd_) {
+            Metrics::Add(Counter::REJECTS);
             SendError(fd, "Server is busy!");
             spdlog::warn("server is full!");
             return;
         }
-        // 创建 HttpConn
-        clients_[fd].Init(fd, addr);
-        // 创建定时器
-        if (kTimeout_ > 0) {
-            timer_heap_->Add(
-                fd, kTimeout_,
-                std::bind(&WebServer::CloseConn, this, &clients_[fd]));
-        }
-        // 注册事件
-        epoller_->Add(fd, EPOLLIN | connfd_event_);
+        Metrics::Add(Counter::ACCEPTS);
         SetFdNonblock(fd);
-        spdlog::info("Client[{}]({}:{}) enter. \t[client count:{}]",
-                     clients_[fd].sockfd(), clients_[fd].ip(),
-                     clients_[fd].port(), HttpConn::client_count_);
+        // 交给某个 Reactor 负责：创建 HttpConn、定时器，并注册事件
+        NextReactor(fd)->AddConn(fd, addr);
     }
 }
 
-void WebServer::HandleReadableEvent(HttpConn* client) {
-    assert(client);
-    ResetTimer(client);
-    thread_pool_->AddTask(std::bind(&WebServer::OnRead, this, client));
-}
-
-void WebServer::HandleWritableEvent(HttpConn* client) {
-    assert(client);
-    ResetTimer(client);
-    thread_pool_->AddTask(std::bind(&WebServer::OnWrite, this, client));
-}
-
-void WebServer::ResetTimer(HttpConn* client) {
-    assert(client);
-    if (kTimeout_ > 0) {
-        timer_heap_->Adjust(client->sockfd(), kTimeout_);
-    }
-}
-
-// 由工作线程负责执行
-// 从 connfd 中读数据
-void WebServer::OnRead(HttpConn* client) {
-    assert(client);
-    int ret = -1;
-    int read_errno = 0;
-    ret = client->Read(&read_errno);
-    // 发生错误
-    if (ret == -1 && read_errno != EAGAIN) {
-        CloseConn(client);
-        return;
-    }
-    // 对方已关闭连接
-    if (ret == 0) {
-        CloseConn(client);
-        return;
-    }
-    // 处理（解析）刚刚读到的数据
-    OnProcess(client);
-}
-
-// 由工作线程负责执行
-// 紧跟在 OnRead 之后执行
-// 处理实际包含两个部分工作：解析请求报文、生成响应报文内容（并将其填充到写缓冲区中）
-void WebServer::OnProcess(HttpConn* client) {
-    if (client->Process()) {
-        // 处理完成，响应报文已经准备完毕（响应报文已经被填充到用户读缓冲区中），接下来就只要准备写了
-        epoller_->Modify(client->sockfd(), connfd_event_ | EPOLLOUT);
-    } else {
-        // 未处理完成，说明请求报文不完整，接下来还得继续读
-        epoller_->Modify(client->sockfd(), connfd_event_ | EPOLLIN);
+// INCOMING_CPU 策略：为每个 CPU 选定负责的 Reactor
+// 优先选绑定在该 CPU 上的 Reactor，其次是绑定在同一 NUMA 结点上的 Reactor（多个时按 CPU 编号轮流），
+// 都没有时（如 Reactor 未绑定 CPU）按 CPU 编号取模，同一个 CPU 收到的连接仍然落在同一个 Reactor 上
+void WebServer::BuildSteeringMap() {
+    const int n = reactors_.size();
+    cpu_to_reactor_.assign(CpuAffinity::CpuCount(), -1);
+    for (int cpu = 0; cpu < static_cast<int>(cpu_to_reactor_.size()); ++cpu) {
+        int node = CpuAffinity::NodeOf(cpu);
+        std::vector<int> local;
+        for (int i = 0; i < n; ++i) {
+            int bound = reactors_[i]->cpu();
+            if (bound == cpu) {
+                cpu_to_reactor_[cpu] = i;
+                break;
+            }
+            if (bound >= 0 && node >= 0 && CpuAffinity::NodeOf(bound) == node) {
+                local.push_back(i);
+            }
+        }
+        if (cpu_to_reactor_[cpu] < 0) {
+            cpu_to_reactor_[cpu] =
+                local.empty() ? cpu % n : local[cpu % local.size()];
+        }
     }
 }
 
-// 由工作线程负责执行
-// 往 connfd 中写数据
-void WebServer::OnWrite(HttpConn* client) {
-    assert(client);
-    int ret = -1;
-    int write_errno = 0;
-    ret = client->Write(&write_errno);
-    if (client->ToWriteBytes() == 0 && client->IsKeepAlive()) {
-        // 传输完成，但需要保持连接
-        OnProcess(client);  // 这个调用的效果实际上只是重新初始化了 HttpRequst 对象
-        return;
+// 选择负责新连接的 Reactor
+Reactor* WebServer::NextReactor(int fd) {
+#ifdef SO_INCOMING_CPU
+    if (kDispatchPolicy_ == DispatchPolicy::INCOMING_CPU) {
+        // 最后处理该连接数据包（软中断）的 CPU，没有收到过数据包时为 -1
+        int cpu = -1;
+        socklen_t len = sizeof(cpu);
+        if (getsockopt(fd, SOL_SOCKET, SO_INCOMING_CPU, &cpu, &len) == 0 &&
+            cpu >= 0 && cpu < static_cast<int>(cpu_to_reactor_.size())) {
+            return reactors_[cpu_to_reactor_[cpu]].get();
+        }
     }
-    if (ret == -1 && write_errno == EAGAIN) {
-        // 未传输完成，需要等下一次可写
-        epoller_->Modify(client->sockfd(), connfd_event_ | EPOLLOUT);
-        return;
+#endif
+    if (kDispatchPolicy_ == DispatchPolicy::LEAST_LOAD) {
+        Reactor* res = reactors_[0].get();
+        for (auto& reactor : reactors_) {
+            if (reactor->conn_count() < res->conn_count()) {
+                res = reactor.get();
+            }
+        }
+        return res;
     }
-    // 非预期情况，关闭连接
-    CloseConn(client);
+    Reactor* res = reactors_[next_reactor_].get();
+    next_reactor_ = (next_reactor_ + 1) % reactors_.size();
+    return res;
 }
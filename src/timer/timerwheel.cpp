@@ -0,0 +1,184 @@
+// Author: Cukoo
+// Date: 2026-10-18
+
+#include "timer/timerwheel.h"
+
+#include <algorithm>
+#include <climits>
+
+TimerWheel::TimerWheel(TimeoutHandler handler, void* ctx)
+    : handler_(handler), ctx_(ctx), current_(Now()), size_(0) {
+    assert(handler_);
+    for (int level = 0; level < kLevels_; ++level) {
+        for (int slot = 0; slot < kSlots_; ++slot) {
+            slots_[level][slot].prev = slots_[level][slot].next =
+                &slots_[level][slot];
+        }
+        occupied_[level] = 0;
+    }
+}
+
+// 将剩余的结点标记为未链入，被定时的对象可能比时间轮活得更久
+TimerWheel::~TimerWheel() {
+    for (int level = 0; level < kLevels_; ++level) {
+        for (int slot = 0; slot < kSlots_; ++slot) {
+            TimerNode* head = &slots_[level][slot];
+            while (head->next != head) {
+                TimerNode* node = head->next;
+                head->next = node->next;
+                node->prev = node->next = nullptr;
+            }
+        }
+    }
+}
+
+// 添加定时器，或更新已有定时器的超时时间
+// 超时时间延后时只记录新的超时时刻，不移动结点（惰性）
+void TimerWheel::Schedule(TimerNode* node, int timeout) {
+    assert(node && timeout >= 0);
+    int64_t expires = Now() + timeout;
+    if (node->IsLinked()) {
+        node->expires = expires;
+        if (expires >= node->scheduled) {
+            return;
+        }
+        Unlink(node);
+    }
+    node->expires = expires;
+    Link(node);
+}
+
+// 删除定时器，结点未链入时什么也不做
+void TimerWheel::Cancel(TimerNode* node) {
+    assert(node);
+    if (node->IsLinked()) {
+        Unlink(node);
+    }
+}
+
+// 处理当前所有超时的结点，并返回距离下一次需要处理的时间（没有定时器时返回 -1）
+int TimerWheel::Tick() {
+    int64_t now = Now();
+    if (size_ == 0) {
+        current_ = std::max(current_, now);
+        return -1;
+    }
+    while (current_ < now) {
+        if (size_ == 0) {
+            current_ = now;
+            break;
+        }
+        ++current_;
+        // 低一层转完一圈时，把高一层对应槽位中的结点重新分配到低层
+        for (int level = 1; level < kLevels_; ++level) {
+            if ((current_ & ((int64_t(1) << (kSlotBits_ * level)) - 1)) != 0) {
+                break;
+            }
+            Cascade(level);
+        }
+        Expire(&slots_[0][current_ & (kSlots_ - 1)]);
+    }
+    return NextTimeout();
+}
+
+size_t TimerWheel::size() const {
+    return size_;
+}
+
+// 按与当前时刻的距离选择层，按超时时刻选择槽位
+void TimerWheel::Link(TimerNode* node) {
+    const int64_t kMaxDelta = (int64_t(1) << (kSlotBits_ * kLevels_)) - 1;
+    int64_t expires = std::max(node->expires, current_ + 1);
+    expires = std::min(expires, current_ + kMaxDelta);
+    int64_t delta = expires - current_;
+    int level = 0;
+    while (level < kLevels_ - 1 &&
+           delta >= (int64_t(1) << (kSlotBits_ * (level + 1)))) {
+        ++level;
+    }
+    int slot = (expires >> (kSlotBits_ * level)) & (kSlots_ - 1);
+    TimerNode* head = &slots_[level][slot];
+    node->scheduled = expires;
+    node->prev = head->prev;
+    node->next = head;
+    head->prev->next = node;
+    head->prev = node;
+    occupied_[level] |= uint64_t(1) << slot;
+    ++size_;
+}
+
+void TimerWheel::Unlink(TimerNode* node) {
+    // 链表中只剩头结点时，清除该槽位在位图中的标记
+    if (node->prev == node->next) {
+        int idx = node->prev - &slots_[0][0];
+        occupied_[idx / kSlots_] &= ~(uint64_t(1) << (idx % kSlots_));
+    }
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    node->prev = node->next = nullptr;
+    --size_;
+}
+
+// 把高层槽位中的结点取下，按新的距离重新放入（结点可能放回同一个槽位，因此先整体取下）
+void TimerWheel::Cascade(int level) {
+    int slot = (current_ >> (kSlotBits_ * level)) & (kSlots_ - 1);
+    TimerNode* head = &slots_[level][slot];
+    if (head->next == head) {
+        return;
+    }
+    TimerNode* node = head->next;
+    head->prev->next = nullptr;
+    head->prev = head->next = head;
+    occupied_[level] &= ~(uint64_t(1) << slot);
+    while (node) {
+        TimerNode* next = node->next;
+        node->prev = node->next = nullptr;
+        --size_;
+        Link(node);
+        node = next;
+    }
+}
+
+// 处理第 0 层当前槽位中的结点：延后过的结点重新放入，其余的执行超时回调
+// 回调中可能删除或添加其他定时器，因此每次只取下一个结点
+void TimerWheel::Expire(TimerNode* head) {
+    while (head->next != head) {
+        TimerNode* node = head->next;
+        Unlink(node);
+        if (node->expires > current_) {
+            Link(node);
+        } else {
+            handler_(ctx_, node);
+        }
+    }
+}
+
+// 各层中下一个非空槽位被处理的时刻，取最小值
+int TimerWheel::NextTimeout() const {
+    int64_t next = INT64_MAX;
+    for (int level = 0; level < kLevels_; ++level) {
+        if (occupied_[level] == 0) {
+            continue;
+        }
+        int shift = kSlotBits_ * level;
+        int64_t base = current_ >> shift;
+        int rot = (base + 1) & (kSlots_ - 1);
+        uint64_t bits = occupied_[level];
+        if (rot != 0) {
+            bits = (bits >> rot) | (bits << (kSlots_ - rot));
+        }
+        int64_t tick = (base + 1 + __builtin_ctzll(bits)) << shift;
+        next = std::min(next, tick);
+    }
+    if (next == INT64_MAX) {
+        return -1;
+    }
+    int64_t res = next - Now();
+    return static_cast<int>(std::clamp<int64_t>(res, 0, INT_MAX));
+}
+
+int64_t TimerWheel::Now() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
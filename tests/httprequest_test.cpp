@@ -0,0 +1,123 @@
+// Author: Cukoo
+// Date: 2026-10-18
+
+// HttpRequest 的单元测试：请求体分段到达时交给处理函数的顺序
+
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer.h"
+#include "http/httprequest.h"
+
+namespace {
+
+using ParseResult = HttpRequest::ParseResult;
+
+// 把 req 按 cuts 中的位置切开，逐段放入读缓冲区并解析，返回每次 Parse 的结果
+std::vector<ParseResult> Feed(HttpRequest& request, Buffer& buff,
+                              const std::string& req,
+                              const std::vector<size_t>& cuts) {
+    std::vector<ParseResult> results;
+    size_t off = 0;
+    for (size_t i = 0; i <= cuts.size(); ++i) {
+        size_t end = i < cuts.size() ? cuts[i] : req.size();
+        buff.Append(req.data() + off, end - off);
+        off = end;
+        results.push_back(request.Parse(buff));
+    }
+    return results;
+}
+
+// 分块传输的请求体分多次读入：切分点落在块大小行、块数据和块后的空行中间，
+// 处理函数按顺序收到解码后的块数据，且只有块数据
+TEST(HttpRequestBodyHandler, ChunkedPiecesArriveInOrder) {
+    const std::string head =
+        "POST /upload HTTP/1.1\r\nHost: localhost\r\n"
+        "Transfer-Encoding: chunked\r\n\r\n";
+    const std::string req =
+        head + "5\r\nHello\r\n2\r\n, \r\n6;ext=1\r\nworld!\r\n0\r\n\r\n";
+    const size_t body = head.size();
+    // "5\r" | "\nHel" | "lo\r\n2\r\n, \r" | "\n6;ex" | "t=1\r\nwor" | "ld!\r\n0\r\n" | "\r\n"
+    const std::vector<size_t> cuts = {body + 2,  body + 6,  body + 16,
+                                      body + 21, body + 29, body + 37};
+
+    HttpRequest request;
+    Buffer buff;
+    std::vector<std::string> pieces;
+    request.SetBodyHandler([&](const char* data, size_t len) {
+        pieces.emplace_back(data, len);
+        return true;
+    });
+    std::vector<ParseResult> results = Feed(request, buff, req, cuts);
+
+    for (size_t i = 0; i + 1 < results.size(); ++i) {
+        EXPECT_EQ(results[i], ParseResult::INCOMPLETE) << "read " << i;
+    }
+    EXPECT_EQ(results.back(), ParseResult::COMPLETE);
+    const std::vector<std::string> expected = {"Hel", "lo", ", ", "wor", "ld!"};
+    EXPECT_EQ(pieces, expected);
+    // 处理函数之后请求体仍然交给 BodyStore
+    EXPECT_EQ(request.body(), "Hello, world!");
+}
+
+// Content-Length 的请求体即使一次全部到达，也交给处理函数
+TEST(HttpRequestBodyHandler, ContentLengthBody) {
+    const std::string req =
+        "POST /upload HTTP/1.1\r\nHost: localhost\r\nContent-Length: 11\r\n\r\n"
+        "hello world";
+    HttpRequest request;
+    Buffer buff;
+    std::string received;
+    request.SetBodyHandler([&](const char* data, size_t len) {
+        received.append(data, len);
+        return true;
+    });
+    buff.Append(req);
+    EXPECT_EQ(request.Parse(buff), ParseResult::COMPLETE);
+    EXPECT_EQ(received, "hello world");
+    EXPECT_EQ(request.body(), "hello world");
+}
+
+// 处理函数返回 false 时请求报文视为有误
+TEST(HttpRequestBodyHandler, RejectFailsRequest) {
+    const std::string req =
+        "POST /upload HTTP/1.1\r\nHost: localhost\r\nContent-Length: 4\r\n\r\n"
+        "abcd";
+    HttpRequest request;
+    Buffer buff;
+    request.SetBodyHandler([](const char*, size_t) { return false; });
+    buff.Append(req);
+    EXPECT_EQ(request.Parse(buff), ParseResult::ERROR);
+    EXPECT_EQ(request.error_code(), 400);
+}
+
+// Init 之后处理函数仍然有效，Release 之后被清除
+TEST(HttpRequestBodyHandler, KeptByInitClearedByRelease) {
+    const std::string req =
+        "POST /upload HTTP/1.1\r\nHost: localhost\r\nContent-Length: 3\r\n\r\n"
+        "abc";
+    HttpRequest request;
+    Buffer buff;
+    int calls = 0;
+    request.SetBodyHandler([&](const char*, size_t) {
+        ++calls;
+        return true;
+    });
+    buff.Append(req);
+    ASSERT_EQ(request.Parse(buff), ParseResult::COMPLETE);
+    request.Retrieve(buff);
+    request.Init();
+    buff.Append(req);
+    ASSERT_EQ(request.Parse(buff), ParseResult::COMPLETE);
+    request.Retrieve(buff);
+    EXPECT_EQ(calls, 2);
+
+    request.Release();
+    buff.Append(req);
+    ASSERT_EQ(request.Parse(buff), ParseResult::COMPLETE);
+    EXPECT_EQ(calls, 2);
+    EXPECT_EQ(request.body(), "abc");
+}
+
+}  // namespace